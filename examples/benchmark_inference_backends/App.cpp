@@ -0,0 +1,100 @@
+/**
+ * @file    App.cpp
+ *
+ * @author  btran
+ *
+ */
+
+#include <torch_cpp/torch_cpp.hpp>
+
+#include "BenchmarkUtility.hpp"
+
+int main(int argc, char* argv[])
+{
+    if (argc != 6 && argc != 7) {
+        std::cerr << "Usage: [app] [torchscript|onnxruntime] [path/to/superpoint/weights] [path/to/superglue/weights] "
+                     "[path/to/image1] [path/to/image2] [num/runs(default: 20)]"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+    const std::string BACKEND_NAME = argv[1];
+    const std::string SUPERPOINT_WEIGHTS_PATH = argv[2];
+    const std::string SUPERGLUE_WEIGHTS_PATH = argv[3];
+    const std::vector<std::string> IMAGE_PATHS = {argv[4], argv[5]};
+    const int NUM_RUNS = argc == 7 ? std::stoi(argv[6]) : 20;
+
+    if (BACKEND_NAME != "torchscript" && BACKEND_NAME != "onnxruntime") {
+        std::cerr << "unknown backend: " << BACKEND_NAME << std::endl;
+        return EXIT_FAILURE;
+    }
+    const _cv::InferenceBackend backend =
+        BACKEND_NAME == "torchscript" ? _cv::InferenceBackend::TORCHSCRIPT : _cv::InferenceBackend::ONNXRUNTIME;
+
+    std::vector<cv::Mat> grays;
+    std::transform(IMAGE_PATHS.begin(), IMAGE_PATHS.end(), std::back_inserter(grays),
+                   [](const auto& imagePath) { return cv::imread(imagePath, 0); });
+    for (int i = 0; i < 2; ++i) {
+        if (grays[i].empty()) {
+            throw std::runtime_error("failed to open " + IMAGE_PATHS[i]);
+        }
+    }
+
+    // cpu only, to compare both backends on the same device
+    _cv::SuperPoint::Param superPointParam;
+    superPointParam.backend = backend;
+    superPointParam.pathToWeights = SUPERPOINT_WEIGHTS_PATH;
+    _cv::SuperGlue::Param superGlueParam;
+    superGlueParam.backend = backend;
+    superGlueParam.pathToWeights = SUPERGLUE_WEIGHTS_PATH;
+
+    const double rssBeforeLoad = benchmark::getResidentSetSizes().first;
+    cv::Ptr<cv::Feature2D> superPoint;
+    cv::Ptr<_cv::SuperGlue> superGlue;
+    double startupTime = benchmark::measureMilliseconds([&]() {
+        superPoint = _cv::SuperPoint::create(superPointParam);
+        superGlue = _cv::SuperGlue::create(superGlueParam);
+    });
+    const double rssAfterLoad = benchmark::getResidentSetSizes().first;
+
+    std::vector<std::vector<cv::KeyPoint>> keyPointsList(2);
+    std::vector<cv::Mat> descriptorsList(2);
+    std::vector<cv::DMatch> matches;
+    auto runOnce = [&](double& superPointTime, double& superGlueTime) {
+        superPointTime = benchmark::measureMilliseconds([&]() {
+            for (int i = 0; i < 2; ++i) {
+                superPoint->detectAndCompute(grays[i], cv::Mat(), keyPointsList[i], descriptorsList[i]);
+            }
+        });
+        superGlueTime = benchmark::measureMilliseconds([&]() {
+            matches.clear();
+            superGlue->match(descriptorsList[0], keyPointsList[0], grays[0].size(), descriptorsList[1],
+                             keyPointsList[1], grays[1].size(), matches);
+        });
+    };
+
+    double superPointTime, superGlueTime;
+    double firstSuperPointTime, firstSuperGlueTime;
+    runOnce(firstSuperPointTime, firstSuperGlueTime);
+
+    double totalSuperPointTime = 0, totalSuperGlueTime = 0;
+    for (int i = 0; i < NUM_RUNS; ++i) {
+        runOnce(superPointTime, superGlueTime);
+        totalSuperPointTime += superPointTime;
+        totalSuperGlueTime += superGlueTime;
+    }
+    const auto rss = benchmark::getResidentSetSizes();
+
+    std::cout << "backend: " << BACKEND_NAME << "\n"
+              << "number of keypoints: " << keyPointsList[0].size() << ", " << keyPointsList[1].size() << "\n"
+              << "number of matches: " << matches.size() << "\n"
+              << "startup (model loading) time: " << startupTime << " [ms]\n"
+              << "first run time (superpoint x2 / superglue): " << firstSuperPointTime << " / " << firstSuperGlueTime
+              << " [ms]\n"
+              << "mean run time over " << NUM_RUNS << " runs (superpoint x2 / superglue): "
+              << totalSuperPointTime / NUM_RUNS << " / " << totalSuperGlueTime / NUM_RUNS << " [ms]\n"
+              << "rss before loading / after loading / after runs: " << rssBeforeLoad << " / " << rssAfterLoad
+              << " / " << rss.first << " [MB]\n"
+              << "peak rss: " << rss.second << " [MB]" << std::endl;
+
+    return EXIT_SUCCESS;
+}
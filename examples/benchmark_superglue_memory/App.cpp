@@ -0,0 +1,99 @@
+/**
+ * @file    App.cpp
+ *
+ * @author  btran
+ *
+ */
+
+#include <torch_cpp/torch_cpp.hpp>
+
+#include "BenchmarkUtility.hpp"
+
+namespace
+{
+// random keypoints and normalized descriptors of superpoint's size, so that any number of keypoints can be matched
+void makeRandomFeatures(int numKeyPoints, const cv::Size& imageSize, cv::RNG& rng,
+                        std::vector<cv::KeyPoint>& keyPoints, cv::Mat& descriptors);
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc != 4 && argc != 5) {
+        std::cerr << "Usage: [app] [torchscript|onnxruntime] [path/to/superglue/weights] [num/keypoints] "
+                     "[num/runs(default: 5)]"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+    const std::string BACKEND_NAME = argv[1];
+    const std::string SUPERGLUE_WEIGHTS_PATH = argv[2];
+    const int NUM_KEYPOINTS = std::stoi(argv[3]);
+    const int NUM_RUNS = argc == 5 ? std::stoi(argv[4]) : 5;
+
+    if (BACKEND_NAME != "torchscript" && BACKEND_NAME != "onnxruntime") {
+        std::cerr << "unknown backend: " << BACKEND_NAME << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const cv::Size imageSize(640, 480);
+    cv::RNG rng(2022);
+    std::vector<std::vector<cv::KeyPoint>> keyPointsList(2);
+    std::vector<cv::Mat> descriptorsList(2);
+    for (int i = 0; i < 2; ++i) {
+        ::makeRandomFeatures(NUM_KEYPOINTS, imageSize, rng, keyPointsList[i], descriptorsList[i]);
+    }
+
+    _cv::SuperGlue::Param superGlueParam;
+    superGlueParam.backend =
+        BACKEND_NAME == "torchscript" ? _cv::InferenceBackend::TORCHSCRIPT : _cv::InferenceBackend::ONNXRUNTIME;
+    superGlueParam.pathToWeights = SUPERGLUE_WEIGHTS_PATH;
+    cv::Ptr<_cv::SuperGlue> superGlue = _cv::SuperGlue::create(superGlueParam);
+    const double rssAfterLoad = benchmark::getResidentSetSizes().first;
+
+    std::vector<cv::DMatch> matches;
+    auto runOnce = [&]() {
+        return benchmark::measureMilliseconds([&]() {
+            matches.clear();
+            superGlue->match(descriptorsList[0], keyPointsList[0], imageSize, descriptorsList[1], keyPointsList[1],
+                             imageSize, matches);
+        });
+    };
+
+    const double firstRunTime = runOnce();
+    double totalTime = 0;
+    for (int i = 0; i < NUM_RUNS; ++i) {
+        totalTime += runOnce();
+    }
+    const auto rss = benchmark::getResidentSetSizes();
+
+    std::cout << "backend: " << BACKEND_NAME << "\n"
+              << "number of keypoints: " << NUM_KEYPOINTS << "\n"
+              << "first run time: " << firstRunTime << " [ms]\n"
+              << "mean run time over " << NUM_RUNS << " runs: " << totalTime / NUM_RUNS << " [ms]\n"
+              << "rss after loading / after runs: " << rssAfterLoad << " / " << rss.first << " [MB]\n"
+              << "peak rss: " << rss.second << " [MB], " << rss.second - rssAfterLoad
+              << " [MB] more than after loading" << std::endl;
+
+    return EXIT_SUCCESS;
+}
+
+namespace
+{
+void makeRandomFeatures(int numKeyPoints, const cv::Size& imageSize, cv::RNG& rng,
+                        std::vector<cv::KeyPoint>& keyPoints, cv::Mat& descriptors)
+{
+    keyPoints.clear();
+    for (int i = 0; i < numKeyPoints; ++i) {
+        cv::KeyPoint keyPoint(rng.uniform(0.f, static_cast<float>(imageSize.width)),
+                              rng.uniform(0.f, static_cast<float>(imageSize.height)), 1);
+        keyPoint.response = rng.uniform(0.f, 1.f);
+        keyPoints.emplace_back(std::move(keyPoint));
+    }
+
+    descriptors.create(numKeyPoints, 256, CV_32F);
+    rng.fill(descriptors, cv::RNG::NORMAL, cv::Scalar(0), cv::Scalar(1));
+    for (int i = 0; i < numKeyPoints; ++i) {
+        cv::Mat descriptor = descriptors.row(i);
+        descriptor /= cv::norm(descriptor);
+    }
+}
+}  // namespace
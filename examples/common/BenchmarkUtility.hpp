@@ -0,0 +1,46 @@
+/**
+ * @file    BenchmarkUtility.hpp
+ *
+ * @author  btran
+ *
+ */
+
+#pragma once
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+
+namespace benchmark
+{
+/**
+ *  @brief VmRSS (current) and VmHWM (peak) resident set sizes in MB
+ */
+inline std::pair<double, double> getResidentSetSizes()
+{
+    std::ifstream ifs("/proc/self/status");
+    std::pair<double, double> rss = {0, 0};
+    std::string line;
+    while (std::getline(ifs, line)) {
+        std::istringstream iss(line);
+        std::string key;
+        double value;
+        iss >> key >> value;
+        if (key == "VmRSS:") {
+            rss.first = value / 1024;
+        } else if (key == "VmHWM:") {
+            rss.second = value / 1024;
+        }
+    }
+    return rss;
+}
+
+template <typename Func> double measureMilliseconds(Func&& func)
+{
+    auto start = std::chrono::steady_clock::now();
+    func();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+}  // namespace benchmark
@@ -37,6 +37,7 @@ int main(int argc, char* argv[])
     std::vector<std::vector<cv::KeyPoint>> keyPointsList(2);
     std::vector<cv::Mat> descriptorsList(2);
     _cv::SuperPoint::Param param;
+    param.backend = _cv::inferenceBackendFromWeights(WEIGHTS_PATH);
     param.pathToWeights = WEIGHTS_PATH;
     param.distThresh = 2;
     param.borderRemove = 4;
@@ -7,12 +7,6 @@
 
 #include <torch_cpp/torch_cpp.hpp>
 
-namespace
-{
-inline void findKeyPointsHomography(const std::vector<cv::KeyPoint>& kpts1, const std::vector<cv::KeyPoint>& kpts2,
-                                    const std::vector<cv::DMatch>& matches, std::vector<char>& matchMask);
-}  // namespace
-
 int main(int argc, char* argv[])
 {
     if (argc != 5) {
@@ -40,6 +34,7 @@ int main(int argc, char* argv[])
     std::vector<std::vector<cv::KeyPoint>> keyPointsList(2);
     std::vector<cv::Mat> descriptorsList(2);
     _cv::SuperPoint::Param superPointParam;
+    superPointParam.backend = _cv::inferenceBackendFromWeights(SUPERPOINT_WEIGHTS_PATH);
     superPointParam.pathToWeights = SUPERPOINT_WEIGHTS_PATH;
     superPointParam.distThresh = 2;
     superPointParam.borderRemove = 4;
@@ -52,6 +47,7 @@ int main(int argc, char* argv[])
     }
 
     _cv::SuperGlue::Param superGlueParam;
+    superGlueParam.backend = _cv::inferenceBackendFromWeights(SUPERGLUE_WEIGHTS_PATH);
     superGlueParam.pathToWeights = SUPERGLUE_WEIGHTS_PATH;
     superGlueParam.gpuIdx = 0;
     cv::Ptr<_cv::SuperGlue> superGlue = _cv::SuperGlue::create(superGlueParam);
@@ -59,8 +55,16 @@ int main(int argc, char* argv[])
     superGlue->match(descriptorsList[0], keyPointsList[0], images[0].size(), descriptorsList[1], keyPointsList[1],
                      images[1].size(), matches);
 
-    std::vector<char> matchMask(matches.size(), 1);
-    ::findKeyPointsHomography(keyPointsList[0], keyPointsList[1], matches, matchMask);
+    _cv::GeometricVerifier::Param verifierParam;
+    verifierParam.model = _cv::GeometricVerifier::Model::HOMOGRAPHY;
+    verifierParam.inlierThresh = 4;
+    cv::Ptr<_cv::GeometricVerifier> verifier = _cv::GeometricVerifier::create(verifierParam);
+    std::vector<char> matchMask;
+    cv::Mat H = verifier->verify(keyPointsList[0], keyPointsList[1], matches, matchMask);
+    if (H.empty()) {
+        // too few matches to verify, draw all of them
+        matchMask.assign(matches.size(), 1);
+    }
     cv::Mat res;
     cv::drawMatches(images[0], keyPointsList[0], images[1], keyPointsList[1], matches, res, cv::Scalar::all(-1),
                     cv::Scalar::all(-1), matchMask, cv::DrawMatchesFlags::NOT_DRAW_SINGLE_POINTS);
@@ -71,21 +75,3 @@ int main(int argc, char* argv[])
 
     return EXIT_SUCCESS;
 }
-
-namespace
-{
-inline void findKeyPointsHomography(const std::vector<cv::KeyPoint>& kpts1, const std::vector<cv::KeyPoint>& kpts2,
-                                    const std::vector<cv::DMatch>& matches, std::vector<char>& matchMask)
-{
-    if (matchMask.size() < 3) {
-        return;
-    }
-    std::vector<cv::Point2f> pts1;
-    std::vector<cv::Point2f> pts2;
-    for (std::size_t i = 0; i < matches.size(); ++i) {
-        pts1.emplace_back(kpts1[matches[i].queryIdx].pt);
-        pts2.emplace_back(kpts2[matches[i].trainIdx].pt);
-    }
-    cv::findHomography(pts1, pts2, cv::RANSAC, 4, matchMask);
-}
-}  // namespace
@@ -17,6 +17,7 @@ int main(int argc, char* argv[])
     const std::string IMAGE_PATH = argv[2];
 
     _cv::SuperPoint::Param param;
+    param.backend = _cv::inferenceBackendFromWeights(WEIGHTS_PATH);
     param.pathToWeights = WEIGHTS_PATH;
     param.distThresh = 5;
     param.gpuIdx = 0;
@@ -0,0 +1,69 @@
+/**
+ * @file    GeometricVerifier.hpp
+ *
+ * @author  btran
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+namespace _cv
+{
+class GeometricVerifier
+{
+ public:
+    enum class Model {
+        HOMOGRAPHY = 0,
+        FUNDAMENTAL = 1,
+        ESSENTIAL = 2,
+    };
+
+    struct Param {
+        Model model = Model::HOMOGRAPHY;
+
+        // in pixels. transfer error for homography, sampson distance for fundamental/essential
+        double inlierThresh = 4.0;
+        double confidence = 0.999;
+        int maxIterations = 2000;
+
+        // number of hypotheses that are solved and scored in parallel in one round
+        int numHypothesesPerRound = 64;
+
+        // only used by essential model
+        cv::Matx33d cameraMatrix = cv::Matx33d::eye();
+
+        std::uint64_t seed = 2022;
+    };
+
+    static cv::Ptr<GeometricVerifier> create(const Param& param);
+
+    /**
+     *  @brief PROSAC estimation of the geometric model between two images.
+     *
+     *  Matches with smaller cv::DMatch::distance are sampled first, so the distance must decrease with the
+     *  confidence of the match (SuperGlue::match stores 1 - matching score).
+     *
+     *  @return 3x3 CV_64F model, empty if no model could be estimated. matchMask is set to 1 for inlier matches.
+     */
+    virtual cv::Mat verify(const std::vector<cv::KeyPoint>& queryKeypoints,
+                           const std::vector<cv::KeyPoint>& trainKeypoints, const std::vector<cv::DMatch>& matches,
+                           CV_OUT std::vector<char>& matchMask) const = 0;
+
+    /**
+     *  @brief verify many image pairs concurrently.
+     *
+     *  matchesList[i] holds the matches between keyPointsList[imagePairs[i].first] (query) and
+     *  keyPointsList[imagePairs[i].second] (train).
+     */
+    virtual void verify(const std::vector<std::vector<cv::KeyPoint>>& keyPointsList,
+                        const std::vector<std::pair<int, int>>& imagePairs,
+                        const std::vector<std::vector<cv::DMatch>>& matchesList, CV_OUT std::vector<cv::Mat>& models,
+                        CV_OUT std::vector<std::vector<char>>& matchMasks) const = 0;
+};
+}  // namespace _cv
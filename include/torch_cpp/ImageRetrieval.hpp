@@ -0,0 +1,69 @@
+/**
+ * @file    ImageRetrieval.hpp
+ *
+ * @author  btran
+ *
+ */
+
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+namespace _cv
+{
+/**
+ *  @brief VLAD aggregation of local descriptors (e.g. SuperPoint's) into one global vector per image, indexed by an
+ *  inverted file (IVF) to retrieve candidate images before running SuperGlue on them
+ */
+class ImageRetrieval
+{
+ public:
+    struct Param {
+        int numVisualWords = 64;
+
+        // pca dimension of the global descriptor. set value <= 0 to keep the full numVisualWords x descriptor size
+        // vlad vector. train() needs at least this many images to fit the pca
+        int globalDescriptorSize = 256;
+
+        int numLists = 16;  // inverted lists of the ivf index
+        int numProbes = 4;  // inverted lists scanned per query
+
+        int maxTrainingDescriptors = 200000;
+        std::string pathToVocabulary = "";  // load a vocabulary saved by save() instead of calling train()
+    };
+
+    static cv::Ptr<ImageRetrieval> create(const Param& param);
+
+    /**
+     *  @brief train the vocabulary, the pca projection and the coarse quantizer of the index. images added before
+     *  are removed from the index.
+     */
+    virtual void train(const std::vector<cv::Mat>& descriptorsList) = 0;
+
+    virtual void save(const std::string& path) const = 0;
+
+    virtual void computeGlobalDescriptor(cv::InputArray _descriptors, cv::OutputArray _globalDescriptor) const = 0;
+
+    /**
+     *  @return index of the added image
+     */
+    virtual int add(cv::InputArray _descriptors) = 0;
+
+    /**
+     *  @brief top-k most similar indexed images. cv::DMatch::trainIdx is the image index, cv::DMatch::distance is 1 -
+     *  cosine similarity of the global descriptors.
+     */
+    virtual void query(cv::InputArray _descriptors, int k, CV_OUT std::vector<cv::DMatch>& candidates) const = 0;
+
+    /**
+     *  @brief pairs (i, j), i < j, of indexed images where one is among the k nearest neighbors of the other
+     */
+    virtual void findCandidatePairs(int k, CV_OUT std::vector<std::pair<int, int>>& imagePairs) const = 0;
+
+    virtual int size() const = 0;
+};
+}  // namespace _cv
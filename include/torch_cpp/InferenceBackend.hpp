@@ -0,0 +1,30 @@
+/**
+ * @file    InferenceBackend.hpp
+ *
+ * @author  btran
+ *
+ */
+
+#pragma once
+
+#include <string>
+
+namespace _cv
+{
+enum class InferenceBackend {
+    TORCHSCRIPT = 0,  // *.pt models scripted by scripts/superglue/jit_*.py
+    ONNXRUNTIME = 1,  // *.onnx models exported by scripts/superglue/onnx_*.py, cpu only
+};
+
+/**
+ *  @brief onnxruntime for *.onnx weights, torchscript otherwise
+ */
+inline InferenceBackend inferenceBackendFromWeights(const std::string& pathToWeights)
+{
+    const std::string onnxExtension = ".onnx";
+    const bool isOnnx = pathToWeights.size() >= onnxExtension.size() &&
+                        pathToWeights.compare(pathToWeights.size() - onnxExtension.size(), onnxExtension.size(),
+                                              onnxExtension) == 0;
+    return isOnnx ? InferenceBackend::ONNXRUNTIME : InferenceBackend::TORCHSCRIPT;
+}
+}  // namespace _cv
@@ -12,12 +12,15 @@
 
 #include <opencv2/opencv.hpp>
 
+#include "InferenceBackend.hpp"
+
 namespace _cv
 {
 class SuperGlue
 {
  public:
     struct Param {
+        InferenceBackend backend = InferenceBackend::TORCHSCRIPT;
         std::string pathToWeights = "";
         float matchThreshold = 0.1;
         int gpuIdx = -1;  // use gpu >= 0 to specify cuda device
@@ -25,6 +28,10 @@ class SuperGlue
 
     static cv::Ptr<SuperGlue> create(const Param& param);
 
+    /**
+     *  @brief cv::DMatch::distance of each match is set to 1 - matching score, so more confident matches have smaller
+     *  distances
+     */
     virtual void match(cv::InputArray _queryDescriptors, const std::vector<cv::KeyPoint>& queryKeypoints,
                        const cv::Size& querySize, cv::InputArray _trainDescriptors,
                        const std::vector<cv::KeyPoint>& trainKeypoints, const cv::Size& trainSize,
@@ -11,6 +11,8 @@
 
 #include <opencv2/opencv.hpp>
 
+#include "InferenceBackend.hpp"
+
 namespace _cv
 {
 class CV_EXPORTS_W SuperPoint : public cv::Feature2D
@@ -22,11 +24,19 @@ class CV_EXPORTS_W SuperPoint : public cv::Feature2D
         int imageHeight = 480;
         int imageWidth = 640;
 
+        InferenceBackend backend = InferenceBackend::TORCHSCRIPT;
         std::string pathToWeights = "";
+
+        // borderRemove and distThresh are fixed at export for onnxruntime models
         int borderRemove = 4;
         float confidenceThresh = 0.015;
         int distThresh = 2;  // nms. set value <= 0 to deactivate nms
         int gpuIdx = -1;     // use gpu >= 0 to specify cuda device
+
+        // run the network only on crops around the regions of the mask instead of on the whole frame.
+        // overlapping crops are merged, then the closest ones until there are at most maxNumCrops.
+        bool cropToMask = false;
+        int maxNumCrops = 4;
     };
 
     CV_WRAP static cv::Ptr<SuperPoint> create(const Param& param);
@@ -7,6 +7,12 @@
 
 #pragma once
 
+#include "GeometricVerifier.hpp"
+
+#include "ImageRetrieval.hpp"
+
+#include "InferenceBackend.hpp"
+
 #include "SuperGlue.hpp"
 
 #include "SuperPoint.hpp"
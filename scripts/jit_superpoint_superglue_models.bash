@@ -13,3 +13,11 @@ python3 -m pip install -r $ROOT_DIR/scripts/superglue/SuperGluePretrainedNetwork
 cd $ROOT_DIR/data
 python3 $ROOT_DIR/scripts/superglue/jit_superglue_model.py
 python3 $ROOT_DIR/scripts/superglue/jit_superpoint_model.py
+
+# superglue for large numbers of keypoints, with attention and sinkhorn run on blocks of keypoints
+python3 $ROOT_DIR/scripts/superglue/jit_superglue_model.py --memory_efficient --output_path superglue_model_memory_efficient.pt
+python3 $ROOT_DIR/scripts/superglue/test_memory_efficient_superglue.py
+
+# onnx models for the onnxruntime backend
+python3 $ROOT_DIR/scripts/superglue/onnx_superglue_model.py
+python3 $ROOT_DIR/scripts/superglue/onnx_superpoint_model.py
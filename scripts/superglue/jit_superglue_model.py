@@ -3,15 +3,40 @@ import os
 import torch
 
 from SuperGluePretrainedNetwork.models.superglue import SuperGlue
+from superglue_memory_efficient import SuperGlueMemoryEfficient
 
 
-def main():
+def get_args():
+    import argparse
+
+    parser = argparse.ArgumentParser("")
+    parser.add_argument(
+        "--memory_efficient",
+        action="store_true",
+        help="run attention and sinkhorn on blocks of keypoints",
+    )
+    parser.add_argument("--block_size", type=int, default=1024)
+    parser.add_argument(
+        "--cache_scores",
+        action="store_true",
+        help="cache the m x n sinkhorn scores: faster, but memory is no longer linear",
+    )
+    parser.add_argument("--output_path", type=str, default="superglue_model.pt")
+
+    return parser.parse_args()
+
+
+def main(args):
     superglue = SuperGlue({"weights": "outdoor"}).eval()
+    if args.memory_efficient:
+        superglue = SuperGlueMemoryEfficient(
+            superglue, args.block_size, args.cache_scores
+        ).eval()
 
     scripted_module = torch.jit.script(superglue)
-    scripted_module.save("superglue_model.pt")
-    print(f"\nsuperglue model is saved to: {os.getcwd()}/superglue_model.pt")
+    scripted_module.save(args.output_path)
+    print(f"\nsuperglue model is saved to: {os.path.abspath(args.output_path)}")
 
 
 if __name__ == "__main__":
-    main()
+    main(get_args())
@@ -0,0 +1,198 @@
+import os
+
+import torch
+
+from SuperGluePretrainedNetwork.models.superglue import (
+    SuperGlue,
+    log_sinkhorn_iterations,
+)
+
+
+def get_args():
+    import argparse
+
+    parser = argparse.ArgumentParser("")
+    parser.add_argument("--opset_version", type=int, default=16)
+
+    return parser.parse_args()
+
+
+def normalize_keypoints(kpts: torch.Tensor, image_shape: torch.Tensor) -> torch.Tensor:
+    """same as the scripted model: keypoints are (y, x), image_shape is [1, 1, height, width]"""
+    size = image_shape[2:].to(kpts)[None]
+    center = size / 2
+    scaling = size.max(1, keepdim=True).values * 0.7
+    return (kpts - center[:, None, :]) / scaling[:, None, :]
+
+
+def log_optimal_transport(
+    scores: torch.Tensor, alpha: torch.Tensor, iters: int
+) -> torch.Tensor:
+    """log_optimal_transport with the number of keypoints kept as traced tensors"""
+    b, m, n = scores.shape
+    one = scores.new_tensor(1)
+    ms, ns = (m * one).to(scores), (n * one).to(scores)
+
+    bins0 = alpha.expand(b, m, 1)
+    bins1 = alpha.expand(b, 1, n)
+    alpha = alpha.expand(b, 1, 1)
+
+    couplings = torch.cat(
+        [torch.cat([scores, bins0], -1), torch.cat([bins1, alpha], -1)], 1
+    )
+
+    norm = -(ms + ns).log()
+    log_mu = torch.cat([norm.expand(m), ns.log()[None] + norm])
+    log_nu = torch.cat([norm.expand(n), ms.log()[None] + norm])
+    log_mu, log_nu = log_mu[None].expand(b, -1), log_nu[None].expand(b, -1)
+
+    Z = log_sinkhorn_iterations(couplings, log_mu, log_nu, iters)
+    Z = Z - norm
+    return Z
+
+
+class SuperGlueOnnx(torch.nn.Module):
+    """SuperGlue with tensor inputs and outputs, traceable for onnx export"""
+
+    def __init__(self, superglue: SuperGlue):
+        super().__init__()
+        self.superglue = superglue
+
+    @staticmethod
+    def attention(
+        attn: torch.nn.Module,
+        query: torch.Tensor,
+        key: torch.Tensor,
+        value: torch.Tensor,
+    ) -> torch.Tensor:
+        batch_dim = query.size(0)
+        query, key, value = [
+            l(x).view(batch_dim, attn.dim, attn.num_heads, -1)
+            for l, x in zip(attn.proj, (query, key, value))
+        ]
+        scores = torch.einsum("bdhn,bdhm->bhnm", query, key) / attn.dim**0.5
+        prob = torch.nn.functional.softmax(scores, dim=-1)
+        x = torch.einsum("bhnm,bdhm->bdhn", prob, value)
+        return attn.merge(x.contiguous().view(batch_dim, attn.dim * attn.num_heads, -1))
+
+    def propagate(
+        self, layer: torch.nn.Module, x: torch.Tensor, source: torch.Tensor
+    ) -> torch.Tensor:
+        message = self.attention(layer.attn, x, source, source)
+        return layer.mlp(torch.cat([x, message], dim=1))
+
+    def forward(
+        self,
+        descriptors0: torch.Tensor,
+        descriptors1: torch.Tensor,
+        keypoints0: torch.Tensor,
+        keypoints1: torch.Tensor,
+        scores0: torch.Tensor,
+        scores1: torch.Tensor,
+        image0_shape: torch.Tensor,
+        image1_shape: torch.Tensor,
+        match_threshold: torch.Tensor,
+    ):
+        sg = self.superglue
+
+        # Keypoint normalization.
+        kpts0 = normalize_keypoints(keypoints0, image0_shape)
+        kpts1 = normalize_keypoints(keypoints1, image1_shape)
+
+        # Keypoint MLP encoder.
+        desc0 = descriptors0 + sg.kenc.encoder(
+            torch.cat([kpts0.transpose(1, 2), scores0.unsqueeze(1)], dim=1)
+        )
+        desc1 = descriptors1 + sg.kenc.encoder(
+            torch.cat([kpts1.transpose(1, 2), scores1.unsqueeze(1)], dim=1)
+        )
+
+        # Multi-layer Transformer network.
+        for layer, name in zip(sg.gnn.layers, sg.gnn.names):
+            if name == "cross":
+                src0, src1 = desc1, desc0
+            else:
+                src0, src1 = desc0, desc1
+            delta0 = self.propagate(layer, desc0, src0)
+            delta1 = self.propagate(layer, desc1, src1)
+            desc0, desc1 = (desc0 + delta0), (desc1 + delta1)
+
+        # Final MLP projection.
+        mdesc0, mdesc1 = sg.final_proj(desc0), sg.final_proj(desc1)
+
+        # Compute matching descriptor distance.
+        scores = torch.einsum("bdn,bdm->bnm", mdesc0, mdesc1)
+        scores = scores / sg.descriptor_dim**0.5
+
+        # Run the optimal transport.
+        scores = log_optimal_transport(
+            scores, sg.bin_score, iters=sg.sinkhorn_iterations
+        )
+
+        # Get the matches with score above "match_threshold".
+        max0, max1 = scores[:, :-1, :-1].max(2), scores[:, :-1, :-1].max(1)
+        indices0, indices1 = max0.indices, max1.indices
+        arange0 = torch.arange(indices0.shape[1], device=indices0.device)
+        arange1 = torch.arange(indices1.shape[1], device=indices1.device)
+        mutual0 = arange0[None] == indices1.gather(1, indices0)
+        mutual1 = arange1[None] == indices0.gather(1, indices1)
+        zero = scores.new_tensor(0)
+        mscores0 = torch.where(mutual0, max0.values.exp(), zero)
+        mscores1 = torch.where(mutual1, mscores0.gather(1, indices1), zero)
+        valid0 = mutual0 & (mscores0 > match_threshold)
+        valid1 = mutual1 & valid0.gather(1, indices1)
+        indices0 = torch.where(valid0, indices0, indices0.new_tensor(-1))
+        indices1 = torch.where(valid1, indices1, indices1.new_tensor(-1))
+
+        return indices0, indices1, mscores0, mscores1
+
+
+def main(args):
+    superglue = SuperGlue({"weights": "outdoor"}).eval()
+    model = SuperGlueOnnx(superglue).eval()
+
+    num_keypoints = [100, 120]
+    inputs = {}
+    for i, n in enumerate(num_keypoints):
+        inputs[f"descriptors{i}"] = torch.nn.functional.normalize(
+            torch.randn(1, superglue.descriptor_dim, n), dim=1
+        )
+    for i, n in enumerate(num_keypoints):
+        inputs[f"keypoints{i}"] = torch.rand(1, n, 2) * 480
+    for i, n in enumerate(num_keypoints):
+        inputs[f"scores{i}"] = torch.rand(1, n)
+    for i in range(2):
+        inputs[f"image{i}_shape"] = torch.tensor([1.0, 1.0, 480.0, 640.0])
+    inputs["match_threshold"] = torch.tensor([0.1])
+
+    with torch.no_grad():
+        torch.onnx.export(
+            model,
+            tuple(inputs.values()),
+            "superglue_model.onnx",
+            input_names=list(inputs.keys()),
+            output_names=[
+                "matches0",
+                "matches1",
+                "matching_scores0",
+                "matching_scores1",
+            ],
+            dynamic_axes={
+                "descriptors0": {2: "num_keypoints0"},
+                "descriptors1": {2: "num_keypoints1"},
+                "keypoints0": {1: "num_keypoints0"},
+                "keypoints1": {1: "num_keypoints1"},
+                "scores0": {1: "num_keypoints0"},
+                "scores1": {1: "num_keypoints1"},
+                "matches0": {1: "num_keypoints0"},
+                "matches1": {1: "num_keypoints1"},
+                "matching_scores0": {1: "num_keypoints0"},
+                "matching_scores1": {1: "num_keypoints1"},
+            },
+            opset_version=args.opset_version,
+        )
+    print(f"\nsuperglue model is saved to: {os.getcwd()}/superglue_model.onnx")
+
+
+if __name__ == "__main__":
+    main(get_args())
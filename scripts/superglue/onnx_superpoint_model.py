@@ -0,0 +1,128 @@
+import os
+
+import torch
+from torch.onnx.operators import shape_as_tensor
+
+from SuperGluePretrainedNetwork.models.superpoint import (
+    SuperPoint,
+    remove_borders,
+    simple_nms,
+)
+
+
+def get_args():
+    import argparse
+
+    parser = argparse.ArgumentParser("")
+    parser.add_argument("--remove_borders", "-r", type=int, default=4)
+    parser.add_argument("--nms_radius", "-n", type=int, default=2)
+    parser.add_argument("--opset_version", type=int, default=16)
+
+    return parser.parse_args()
+
+
+def sample_descriptors(
+    keypoints: torch.Tensor, descriptors: torch.Tensor, s: int = 8
+) -> torch.Tensor:
+    """patched sample_descriptors with the normalizer computed from the traced shape of
+    descriptors, instead of a constant fixed at the export image size"""
+    b, c, _, _ = descriptors.shape
+    size = shape_as_tensor(descriptors)[2:].flip(0).to(keypoints)  # (w, h)
+    keypoints = keypoints - s / 2 + 0.5
+    keypoints = keypoints / (size * s - s / 2 - 0.5)[None]
+    keypoints = keypoints * 2 - 1  # normalize to (-1, 1)
+    descriptors = torch.nn.functional.grid_sample(
+        descriptors, keypoints.view(b, 1, -1, 2), mode="bilinear", align_corners=True
+    )
+    descriptors = torch.nn.functional.normalize(
+        descriptors.reshape(b, c, -1), p=2.0, dim=1
+    )
+    return descriptors
+
+
+class SuperPointOnnx(torch.nn.Module):
+    """
+    SuperPoint on a single image, traceable for onnx export.
+    remove_borders and nms_radius set kernel sizes and slicing, so they are fixed at export.
+    """
+
+    def __init__(self, superpoint: SuperPoint, remove_borders: int, nms_radius: int):
+        super().__init__()
+        self.superpoint = superpoint
+        self.remove_borders = remove_borders
+        self.nms_radius = nms_radius
+
+    def forward(self, image: torch.Tensor, keypoint_threshold: torch.Tensor):
+        sp = self.superpoint
+
+        # Shared Encoder
+        x = sp.relu(sp.conv1a(image))
+        x = sp.relu(sp.conv1b(x))
+        x = sp.pool(x)
+        x = sp.relu(sp.conv2a(x))
+        x = sp.relu(sp.conv2b(x))
+        x = sp.pool(x)
+        x = sp.relu(sp.conv3a(x))
+        x = sp.relu(sp.conv3b(x))
+        x = sp.pool(x)
+        x = sp.relu(sp.conv4a(x))
+        x = sp.relu(sp.conv4b(x))
+
+        # Compute the dense keypoint scores
+        cPa = sp.relu(sp.convPa(x))
+        scores = sp.convPb(cPa)
+        scores = torch.nn.functional.softmax(scores, 1)[:, :-1]
+        b, _, h, w = scores.shape
+        scores = scores.permute(0, 2, 3, 1).reshape(b, h, w, 8, 8)
+        scores = scores.permute(0, 1, 3, 2, 4).reshape(b, h * 8, w * 8)
+        scores = simple_nms(scores, self.nms_radius)[0]
+
+        # traced shape, so that the borders follow the input size
+        size = shape_as_tensor(scores)
+        height, width = size[0], size[1]
+
+        # Extract keypoints
+        keypoints = torch.nonzero(scores > keypoint_threshold)
+        scores = scores[scores > keypoint_threshold]
+        keypoints, scores = remove_borders(
+            keypoints, scores, self.remove_borders, height, width
+        )
+
+        # Convert (h, w) to (x, y)
+        keypoints = torch.flip(keypoints, [1]).float()
+
+        # Compute the dense descriptors
+        cDa = sp.relu(sp.convDa(x))
+        descriptors = sp.convDb(cDa)
+        descriptors = torch.nn.functional.normalize(descriptors, p=2.0, dim=1)
+        descriptors = sample_descriptors(keypoints[None], descriptors, 8)[0]
+
+        return keypoints, scores, descriptors
+
+
+def main(args):
+    superpoint = SuperPoint({}).eval()
+    model = SuperPointOnnx(superpoint, args.remove_borders, args.nms_radius).eval()
+
+    image = torch.rand(1, 1, 480, 640)
+    keypoint_threshold = torch.tensor([0.015])
+    with torch.no_grad():
+        torch.onnx.export(
+            model,
+            (image, keypoint_threshold),
+            "superpoint_model.onnx",
+            input_names=["image", "keypoint_threshold"],
+            output_names=["keypoints", "scores", "descriptors"],
+            dynamic_axes={
+                "image": {2: "height", 3: "width"},
+                "keypoints": {0: "num_keypoints"},
+                "scores": {0: "num_keypoints"},
+                "descriptors": {1: "num_keypoints"},
+            },
+            opset_version=args.opset_version,
+        )
+    print(f"\nsuperpoint model is saved to: {os.getcwd()}/superpoint_model.onnx")
+
+
+if __name__ == "__main__":
+    main(get_args())
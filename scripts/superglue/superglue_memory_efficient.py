@@ -0,0 +1,278 @@
+from typing import Dict, List, Tuple
+
+import torch
+from torch import nn
+
+from SuperGluePretrainedNetwork.models.superglue import (
+    SuperGlue,
+    _tolist,
+    normalize_keypoints,
+)
+
+
+class ChunkedAttention(nn.Module):
+    """MultiHeadedAttention over blocks of queries and keys, with an online softmax over
+    the key blocks, so that only block_size x block_size scores are kept per head"""
+
+    def __init__(self, attn: nn.Module, block_size: int):
+        super().__init__()
+        self.dim: int = attn.dim
+        self.num_heads: int = attn.num_heads
+        self.block_size = block_size
+        self.proj_query = attn.proj[0]
+        self.proj_key = attn.proj[1]
+        self.proj_value = attn.proj[2]
+        self.merge = attn.merge
+
+    def forward(
+        self, query: torch.Tensor, key: torch.Tensor, value: torch.Tensor
+    ) -> torch.Tensor:
+        batch_dim = query.size(0)
+        query = self.proj_query(query).view(batch_dim, self.dim, self.num_heads, -1)
+        key = self.proj_key(key).view(batch_dim, self.dim, self.num_heads, -1)
+        value = self.proj_value(value).view(batch_dim, self.dim, self.num_heads, -1)
+        query = query / self.dim**0.5
+        n, m = query.size(3), key.size(3)
+
+        x = torch.empty_like(query)
+        for query_start in range(0, n, self.block_size):
+            query_end = min(query_start + self.block_size, n)
+            q = query[:, :, :, query_start:query_end]
+
+            message = torch.zeros_like(q)
+            running_max = torch.full(
+                [batch_dim, self.num_heads, query_end - query_start],
+                float("-inf"),
+                dtype=q.dtype,
+                device=q.device,
+            )
+            running_sum = torch.zeros_like(running_max)
+            for key_start in range(0, m, self.block_size):
+                key_end = min(key_start + self.block_size, m)
+                scores = torch.einsum(
+                    "bdhn,bdhm->bhnm", q, key[:, :, :, key_start:key_end]
+                )
+                new_max = torch.maximum(running_max, scores.max(-1).values)
+                correction = (running_max - new_max).exp()
+                prob = (scores - new_max[:, :, :, None]).exp()
+                running_sum = running_sum * correction + prob.sum(-1)
+                message = message * correction[:, None] + torch.einsum(
+                    "bhnm,bdhm->bdhn", prob, value[:, :, :, key_start:key_end]
+                )
+                running_max = new_max
+            x[:, :, :, query_start:query_end] = message / running_sum[:, None]
+
+        return self.merge(x.view(batch_dim, self.dim * self.num_heads, -1))
+
+
+class ChunkedAttentionalPropagation(nn.Module):
+    def __init__(self, layer: nn.Module, block_size: int):
+        super().__init__()
+        self.attn = ChunkedAttention(layer.attn, block_size)
+        self.mlp = layer.mlp
+
+    def forward(self, x: torch.Tensor, source: torch.Tensor) -> torch.Tensor:
+        message = self.attn(x, source, source)
+        return self.mlp(torch.cat([x, message], dim=1))
+
+
+class SuperGlueMemoryEfficient(nn.Module):
+    """SuperGlue with the same inputs, outputs and weights as the scripted model, where
+    attention, sinkhorn and the mutual matching run on blocks of block_size keypoints.
+
+    the score blocks are recomputed from the final descriptors at each sinkhorn
+    iteration, so that peak memory is linear in the number of keypoints. cache_scores
+    keeps them in one m x n buffer instead, trading memory for one matrix product less
+    per block and iteration.
+    """
+
+    def __init__(
+        self,
+        superglue: SuperGlue,
+        block_size: int = 1024,
+        cache_scores: bool = False,
+    ):
+        super().__init__()
+        if block_size <= 0:
+            raise ValueError('"block_size" must be positive')
+
+        self.descriptor_dim: int = superglue.descriptor_dim
+        self.sinkhorn_iterations: int = superglue.sinkhorn_iterations
+        self.match_threshold: float = superglue.match_threshold
+        self.block_size = block_size
+        self.cache_scores = cache_scores
+
+        self.keypoint_encoder = superglue.kenc.encoder
+        self.layers = nn.ModuleList(
+            [
+                ChunkedAttentionalPropagation(layer, block_size)
+                for layer in superglue.gnn.layers
+            ]
+        )
+        self.names: List[str] = superglue.gnn.names
+        self.final_proj = superglue.final_proj
+        self.bin_score = superglue.bin_score
+
+    def score_block(
+        self, mdesc0: torch.Tensor, mdesc1: torch.Tensor, start: int
+    ) -> torch.Tensor:
+        end = min(start + self.block_size, mdesc0.size(2))
+        scores = torch.einsum("bdn,bdm->bnm", mdesc0[:, :, start:end], mdesc1)
+        return scores / self.descriptor_dim**0.5
+
+    def get_score_block(
+        self,
+        cached_blocks: List[torch.Tensor],
+        mdesc0: torch.Tensor,
+        mdesc1: torch.Tensor,
+        block_idx: int,
+    ) -> torch.Tensor:
+        if self.cache_scores:
+            return cached_blocks[block_idx]
+        return self.score_block(mdesc0, mdesc1, block_idx * self.block_size)
+
+    def log_optimal_transport(
+        self,
+        mdesc0: torch.Tensor,
+        mdesc1: torch.Tensor,
+        cached_blocks: List[torch.Tensor],
+    ) -> Tuple[torch.Tensor, torch.Tensor, torch.Tensor]:
+        """log_optimal_transport on blocks of rows of the couplings, with a streaming
+        log-sum-exp over the row blocks for the column updates.
+
+        returns the log scalings u, v and norm such that the log assignment of the score
+        block starting at row start is block + u[:, start:end, None] + v[:, None, :n] -
+        norm. the dustbins are u[:, m] and v[:, n].
+        """
+        b, m, n = mdesc0.size(0), mdesc0.size(2), mdesc1.size(2)
+        num_blocks = (m + self.block_size - 1) // self.block_size
+        alpha = self.bin_score.to(mdesc0)
+        ms, ns = torch.tensor(m).to(mdesc0), torch.tensor(n).to(mdesc0)
+
+        norm = -(ms + ns).log()
+        log_mu = torch.cat([norm.expand(m), ns.log()[None] + norm])[None].expand(b, -1)
+        log_nu = torch.cat([norm.expand(n), ms.log()[None] + norm])[None].expand(b, -1)
+
+        u, v = torch.zeros_like(log_mu), torch.zeros_like(log_nu)
+        for _ in range(self.sinkhorn_iterations):
+            # rows of the keypoints: log-sum-exp over the columns and the dustbin column
+            row_lses: List[torch.Tensor] = []
+            for i in range(num_blocks):
+                block = self.get_score_block(cached_blocks, mdesc0, mdesc1, i)
+                row_lses.append(
+                    torch.logaddexp(
+                        (block + v[:, None, :n]).logsumexp(2), alpha + v[:, n:]
+                    )
+                )
+            row_lses.append(alpha + v.logsumexp(1, keepdim=True))
+            u = log_mu - torch.cat(row_lses, 1)
+
+            # columns of the keypoints: streaming log-sum-exp over the row blocks,
+            # starting from the dustbin row
+            col_lse = (alpha + u[:, m:]).expand(b, n)
+            for i in range(num_blocks):
+                start = i * self.block_size
+                block = self.get_score_block(cached_blocks, mdesc0, mdesc1, i)
+                col_lse = torch.logaddexp(
+                    col_lse,
+                    (block + u[:, start : start + block.size(1), None]).logsumexp(1),
+                )
+            v = log_nu - torch.cat([col_lse, alpha + u.logsumexp(1, keepdim=True)], 1)
+
+        return u, v, norm
+
+    def forward(self, data: Dict[str, torch.Tensor]) -> Dict[str, torch.Tensor]:
+        desc0, desc1 = data["descriptors0"], data["descriptors1"]
+        kpts0, kpts1 = data["keypoints0"], data["keypoints1"]
+
+        if kpts0.shape[1] == 0 or kpts1.shape[1] == 0:  # no keypoints
+            shape0, shape1 = kpts0.shape[:-1], kpts1.shape[:-1]
+            return {
+                "matches0": torch.full(
+                    shape0, -1, dtype=torch.int, device=kpts0.device
+                ),
+                "matches1": torch.full(
+                    shape1, -1, dtype=torch.int, device=kpts1.device
+                ),
+                "matching_scores0": torch.zeros(shape0, device=kpts0.device),
+                "matching_scores1": torch.zeros(shape1, device=kpts1.device),
+            }
+
+        # Keypoint normalization.
+        kpts0 = normalize_keypoints(kpts0, data["image0_shape"])
+        kpts1 = normalize_keypoints(kpts1, data["image1_shape"])
+
+        # Keypoint MLP encoder.
+        desc0 = desc0 + self.keypoint_encoder(
+            torch.cat([kpts0.transpose(1, 2), data["scores0"].unsqueeze(1)], dim=1)
+        )
+        desc1 = desc1 + self.keypoint_encoder(
+            torch.cat([kpts1.transpose(1, 2), data["scores1"].unsqueeze(1)], dim=1)
+        )
+
+        match_threshold = self.match_threshold
+        if "match_threshold" in data:
+            match_threshold = _tolist(data["match_threshold"])[0]
+
+        # Multi-layer Transformer network.
+        for i, layer in enumerate(self.layers):
+            if self.names[i] == "cross":
+                src0, src1 = desc1, desc0
+            else:
+                src0, src1 = desc0, desc1
+            delta0, delta1 = layer(desc0, src0), layer(desc1, src1)
+            desc0, desc1 = (desc0 + delta0), (desc1 + delta1)
+
+        # Final MLP projection.
+        mdesc0, mdesc1 = self.final_proj(desc0), self.final_proj(desc1)
+
+        # Run the optimal transport on blocks of the matching descriptor distance.
+        m, n = mdesc0.size(2), mdesc1.size(2)
+        num_blocks = (m + self.block_size - 1) // self.block_size
+        cached_blocks: List[torch.Tensor] = []
+        if self.cache_scores:
+            for i in range(num_blocks):
+                cached_blocks.append(
+                    self.score_block(mdesc0, mdesc1, i * self.block_size)
+                )
+        u, v, norm = self.log_optimal_transport(mdesc0, mdesc1, cached_blocks)
+
+        # Mutual max over the blocks of the scores, without the dustbins.
+        values0: List[torch.Tensor] = []
+        indices0_list: List[torch.Tensor] = []
+        values1 = torch.full_like(v[:, :n], float("-inf"))
+        indices1 = torch.zeros(
+            values1.shape, dtype=torch.long, device=values1.device
+        )
+        for i in range(num_blocks):
+            start = i * self.block_size
+            block = self.get_score_block(cached_blocks, mdesc0, mdesc1, i)
+            block = block + u[:, start : start + block.size(1), None]
+            block = block + v[:, None, :n] - norm
+            max0, max1 = block.max(2), block.max(1)
+            values0.append(max0.values)
+            indices0_list.append(max0.indices)
+            update = max1.values > values1
+            values1 = torch.where(update, max1.values, values1)
+            indices1 = torch.where(update, max1.indices + start, indices1)
+        indices0 = torch.cat(indices0_list, 1)
+
+        # Get the matches with score above "match_threshold".
+        arange0 = torch.arange(m, device=indices0.device)
+        arange1 = torch.arange(n, device=indices1.device)
+        mutual0 = arange0[None] == indices1.gather(1, indices0)
+        mutual1 = arange1[None] == indices0.gather(1, indices1)
+        zero = torch.tensor(0).to(mdesc0)
+        mscores0 = torch.where(mutual0, torch.cat(values0, 1).exp(), zero)
+        mscores1 = torch.where(mutual1, mscores0.gather(1, indices1), zero)
+        valid0 = mutual0 & (mscores0 > match_threshold)
+        valid1 = mutual1 & valid0.gather(1, indices1)
+        indices0 = torch.where(valid0, indices0, torch.tensor(-1).to(indices0))
+        indices1 = torch.where(valid1, indices1, torch.tensor(-1).to(indices1))
+
+        return {
+            "matches0": indices0,  # use -1 for invalid match
+            "matches1": indices1,  # use -1 for invalid match
+            "matching_scores0": mscores0,
+            "matching_scores1": mscores1,
+        }
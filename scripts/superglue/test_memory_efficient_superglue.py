@@ -0,0 +1,113 @@
+from typing import Dict
+
+import torch
+
+from SuperGluePretrainedNetwork.models.superglue import SuperGlue
+from superglue_memory_efficient import SuperGlueMemoryEfficient
+
+
+def get_args():
+    import argparse
+
+    parser = argparse.ArgumentParser(
+        "check that the memory-efficient superglue matches the scripted superglue"
+    )
+    parser.add_argument("--block_size", type=int, default=256)
+    parser.add_argument(
+        "--num_keypoints", type=int, nargs="+", default=[1, 300, 700, 1100]
+    )
+    parser.add_argument("--match_threshold", "-m", type=float, default=0.2)
+    parser.add_argument("--atol", type=float, default=1e-4)
+
+    return parser.parse_args()
+
+
+def make_inputs(
+    num_keypoints: int, match_threshold: float, generator: torch.Generator
+) -> Dict[str, torch.Tensor]:
+    """random keypoints where half of the descriptors of image1 are noisy copies of the
+    ones of image0, so that there are matches to compare"""
+    height, width = 480, 640
+    desc0 = torch.randn(1, 256, num_keypoints, generator=generator)
+    desc1 = torch.randn(1, 256, num_keypoints, generator=generator)
+    num_shared = num_keypoints // 2
+    perm = torch.randperm(num_keypoints, generator=generator)[:num_shared]
+    desc1[:, :, :num_shared] = desc0[:, :, perm] + 0.1 * torch.randn(
+        1, 256, num_shared, generator=generator
+    )
+
+    data = {}
+    for i, desc in enumerate([desc0, desc1]):
+        data[f"descriptors{i}"] = torch.nn.functional.normalize(desc, dim=1)
+        data[f"keypoints{i}"] = torch.rand(
+            1, num_keypoints, 2, generator=generator
+        ) * torch.tensor([height, width])
+        data[f"scores{i}"] = torch.rand(1, num_keypoints, generator=generator)
+        data[f"image{i}_shape"] = torch.tensor([1.0, 1.0, height, width])
+    data["match_threshold"] = torch.tensor([match_threshold])
+    return data
+
+
+def compare(
+    expected: Dict[str, torch.Tensor],
+    output: Dict[str, torch.Tensor],
+    match_threshold: float,
+    atol: float,
+) -> bool:
+    is_same = True
+    for suffix in ["0", "1"]:
+        scores, expected_scores = (
+            output["matching_scores" + suffix],
+            expected["matching_scores" + suffix],
+        )
+        matches, expected_matches = (
+            output["matches" + suffix],
+            expected["matches" + suffix],
+        )
+
+        score_error = (scores - expected_scores).abs().max().item()
+        # matches whose score is within atol of the threshold may flip
+        ambiguous = (expected_scores - match_threshold).abs() <= atol
+        different = (matches != expected_matches) & ~ambiguous
+        num_different_matches = different.sum().item()
+        num_matches = (expected_matches >= 0).sum().item()
+        print(
+            f"    matches{suffix}: {num_matches} matches, "
+            f"{num_different_matches} different, max score error {score_error:.2e}"
+        )
+        is_same = is_same and score_error <= atol and num_different_matches == 0
+    return is_same
+
+
+def main(args):
+    superglue = SuperGlue({"weights": "outdoor"}).eval()
+    dense_model = torch.jit.script(superglue)
+    models = {
+        f"cache_scores={cache_scores}": torch.jit.script(
+            SuperGlueMemoryEfficient(superglue, args.block_size, cache_scores).eval()
+        )
+        for cache_scores in [False, True]
+    }
+
+    generator = torch.Generator().manual_seed(2022)
+    is_same = True
+    with torch.no_grad():
+        for num_keypoints in args.num_keypoints:
+            data = make_inputs(num_keypoints, args.match_threshold, generator)
+            expected = dense_model(data)
+            for name, model in models.items():
+                print(
+                    f"{num_keypoints} keypoints, block_size={args.block_size}, {name}"
+                )
+                is_same = (
+                    compare(expected, model(data), args.match_threshold, args.atol)
+                    and is_same
+                )
+
+    if not is_same:
+        raise SystemExit("memory-efficient superglue differs from superglue")
+    print("\nmemory-efficient superglue matches superglue")
+
+
+if __name__ == "__main__":
+    main(get_args())
@@ -0,0 +1,440 @@
+/**
+ * @file    GeometricVerifier.cpp
+ *
+ * @author  btran
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include <torch_cpp/GeometricVerifier.hpp>
+
+namespace
+{
+using Model = _cv::GeometricVerifier::Model;
+
+// correspondences sorted by decreasing confidence, kept as structure of arrays so that residual loops vectorize
+struct Correspondences {
+    std::vector<float> x1, y1, x2, y2;
+
+    int size() const
+    {
+        return x1.size();
+    }
+};
+
+struct Hypothesis {
+    cv::Matx33d model;
+    int numInliers = 0;
+};
+
+/**
+ *  @brief progressive sampling from Chum & Matas, "Matching with PROSAC - Progressive Sample Consensus", CVPR 2005
+ */
+class ProsacSampler
+{
+ public:
+    ProsacSampler(int numPoints, int sampleSize, int maxIterations, std::uint64_t seed);
+
+    void sample(std::vector<int>& indices);
+
+ private:
+    void drawDistinct(int range, int count, std::vector<int>& indices);
+
+ private:
+    int m_numPoints;
+    int m_sampleSize;
+    int m_subsetSize;
+    int m_numIterations;
+    double m_tn;
+    double m_tnPrime;
+    cv::RNG m_rng;
+};
+
+int sampleSize(Model model);
+
+std::vector<cv::Matx33d> solveMinimal(Model model, const std::vector<cv::Point2f>& pts1,
+                                      const std::vector<cv::Point2f>& pts2);
+
+cv::Mat solveNonMinimal(Model model, const std::vector<cv::Point2f>& pts1, const std::vector<cv::Point2f>& pts2);
+
+void computeSquaredResiduals(Model model, const cv::Matx33d& m, const Correspondences& corrs, float* residuals);
+
+int countInliers(const float* residuals, int numResiduals, float sqThresh);
+
+int updateNumIterations(double confidence, double inlierRatio, int sampleSize, int maxIterations);
+}  // namespace
+
+namespace _cv
+{
+class GeometricVerifierImpl : public GeometricVerifier
+{
+ public:
+    explicit GeometricVerifierImpl(const GeometricVerifier::Param& param);
+
+    cv::Mat verify(const std::vector<cv::KeyPoint>& queryKeypoints, const std::vector<cv::KeyPoint>& trainKeypoints,
+                   const std::vector<cv::DMatch>& matches, CV_OUT std::vector<char>& matchMask) const final;
+
+    void verify(const std::vector<std::vector<cv::KeyPoint>>& keyPointsList,
+                const std::vector<std::pair<int, int>>& imagePairs,
+                const std::vector<std::vector<cv::DMatch>>& matchesList, CV_OUT std::vector<cv::Mat>& models,
+                CV_OUT std::vector<std::vector<char>>& matchMasks) const final;
+
+ private:
+    GeometricVerifier::Param m_param;
+};
+
+cv::Ptr<GeometricVerifier> GeometricVerifier::create(const Param& param)
+{
+    return cv::makePtr<GeometricVerifierImpl>(param);
+}
+
+GeometricVerifierImpl::GeometricVerifierImpl(const GeometricVerifier::Param& param)
+    : m_param(param)
+{
+    if (m_param.inlierThresh <= 0) {
+        throw std::runtime_error("inlier threshold must be more than 0");
+    }
+
+    if (m_param.confidence <= 0 || m_param.confidence >= 1) {
+        throw std::runtime_error("confidence must be in (0, 1)");
+    }
+
+    if (m_param.maxIterations <= 0 || m_param.numHypothesesPerRound <= 0) {
+        throw std::runtime_error("number of iterations must be more than 0");
+    }
+
+    if (m_param.model == Model::ESSENTIAL && (m_param.cameraMatrix(0, 0) <= 0 || m_param.cameraMatrix(1, 1) <= 0)) {
+        throw std::runtime_error("invalid camera matrix");
+    }
+}
+
+cv::Mat GeometricVerifierImpl::verify(const std::vector<cv::KeyPoint>& queryKeypoints,
+                                      const std::vector<cv::KeyPoint>& trainKeypoints,
+                                      const std::vector<cv::DMatch>& matches, CV_OUT std::vector<char>& matchMask) const
+{
+    matchMask.assign(matches.size(), 0);
+
+    const int numMatches = matches.size();
+    const int numSamplePoints = ::sampleSize(m_param.model);
+    if (numMatches < numSamplePoints) {
+        return cv::Mat();
+    }
+
+    std::vector<int> order(numMatches);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&matches](int i, int j) { return matches[i].distance < matches[j].distance; });
+
+    // essential matrix is estimated on normalized image coordinates
+    const bool normalize = m_param.model == Model::ESSENTIAL;
+    const cv::Matx33d& K = m_param.cameraMatrix;
+    double inlierThresh = m_param.inlierThresh;
+    if (normalize) {
+        inlierThresh /= (K(0, 0) + K(1, 1)) / 2;
+    }
+    const float sqThresh = inlierThresh * inlierThresh;
+
+    ::Correspondences corrs;
+    for (auto* coords : {&corrs.x1, &corrs.y1, &corrs.x2, &corrs.y2}) {
+        coords->reserve(numMatches);
+    }
+    for (int idx : order) {
+        cv::Point2f p1 = queryKeypoints.at(matches[idx].queryIdx).pt;
+        cv::Point2f p2 = trainKeypoints.at(matches[idx].trainIdx).pt;
+        if (normalize) {
+            p1 = cv::Point2f((p1.x - K(0, 2)) / K(0, 0), (p1.y - K(1, 2)) / K(1, 1));
+            p2 = cv::Point2f((p2.x - K(0, 2)) / K(0, 0), (p2.y - K(1, 2)) / K(1, 1));
+        }
+        corrs.x1.emplace_back(p1.x);
+        corrs.y1.emplace_back(p1.y);
+        corrs.x2.emplace_back(p2.x);
+        corrs.y2.emplace_back(p2.y);
+    }
+
+    ::ProsacSampler sampler(numMatches, numSamplePoints, m_param.maxIterations, m_param.seed);
+    ::Hypothesis best;
+    int maxIterations = m_param.maxIterations;
+    std::vector<std::vector<int>> samples(m_param.numHypothesesPerRound);
+    std::vector<::Hypothesis> hypotheses(m_param.numHypothesesPerRound);
+
+    for (int numIterations = 0; numIterations < maxIterations;) {
+        // sampling is sequential so that the result does not depend on the thread scheduling
+        int numHypotheses = std::min(m_param.numHypothesesPerRound, maxIterations - numIterations);
+        for (int i = 0; i < numHypotheses; ++i) {
+            sampler.sample(samples[i]);
+        }
+
+        cv::parallel_for_(cv::Range(0, numHypotheses), [&](const cv::Range& range) {
+            std::vector<float> residuals(numMatches);
+            std::vector<cv::Point2f> pts1(numSamplePoints), pts2(numSamplePoints);
+            for (int i = range.start; i < range.end; ++i) {
+                hypotheses[i].numInliers = 0;
+                for (int j = 0; j < numSamplePoints; ++j) {
+                    int idx = samples[i][j];
+                    pts1[j] = cv::Point2f(corrs.x1[idx], corrs.y1[idx]);
+                    pts2[j] = cv::Point2f(corrs.x2[idx], corrs.y2[idx]);
+                }
+
+                for (const auto& model : ::solveMinimal(m_param.model, pts1, pts2)) {
+                    ::computeSquaredResiduals(m_param.model, model, corrs, residuals.data());
+                    int numInliers = ::countInliers(residuals.data(), numMatches, sqThresh);
+                    if (numInliers > hypotheses[i].numInliers) {
+                        hypotheses[i].model = model;
+                        hypotheses[i].numInliers = numInliers;
+                    }
+                }
+            }
+        });
+        numIterations += numHypotheses;
+
+        for (int i = 0; i < numHypotheses; ++i) {
+            if (hypotheses[i].numInliers > best.numInliers) {
+                best = hypotheses[i];
+                maxIterations =
+                    ::updateNumIterations(m_param.confidence, static_cast<double>(best.numInliers) / numMatches,
+                                          numSamplePoints, maxIterations);
+            }
+        }
+    }
+
+    if (best.numInliers < numSamplePoints) {
+        return cv::Mat();
+    }
+
+    // refine on all inliers and keep the refined model only if it does not lose support
+    std::vector<float> residuals(numMatches);
+    ::computeSquaredResiduals(m_param.model, best.model, corrs, residuals.data());
+    {
+        std::vector<cv::Point2f> inliers1, inliers2;
+        for (int i = 0; i < numMatches; ++i) {
+            if (residuals[i] <= sqThresh) {
+                inliers1.emplace_back(corrs.x1[i], corrs.y1[i]);
+                inliers2.emplace_back(corrs.x2[i], corrs.y2[i]);
+            }
+        }
+
+        cv::Mat refinedMat = ::solveNonMinimal(m_param.model, inliers1, inliers2);
+        if (!refinedMat.empty()) {
+            cv::Matx33d refined = refinedMat;
+            std::vector<float> refinedResiduals(numMatches);
+            ::computeSquaredResiduals(m_param.model, refined, corrs, refinedResiduals.data());
+            int numInliers = ::countInliers(refinedResiduals.data(), numMatches, sqThresh);
+            if (numInliers >= best.numInliers) {
+                best.model = refined;
+                best.numInliers = numInliers;
+                residuals.swap(refinedResiduals);
+            }
+        }
+    }
+
+    for (int i = 0; i < numMatches; ++i) {
+        matchMask[order[i]] = residuals[i] <= sqThresh;
+    }
+
+    return cv::Mat(best.model, true);
+}
+
+void GeometricVerifierImpl::verify(const std::vector<std::vector<cv::KeyPoint>>& keyPointsList,
+                                   const std::vector<std::pair<int, int>>& imagePairs,
+                                   const std::vector<std::vector<cv::DMatch>>& matchesList,
+                                   CV_OUT std::vector<cv::Mat>& models,
+                                   CV_OUT std::vector<std::vector<char>>& matchMasks) const
+{
+    if (imagePairs.size() != matchesList.size()) {
+        CV_Error(cv::Error::StsBadArg, "number of image pairs and number of match lists mismatch");
+    }
+
+    const int numImages = keyPointsList.size();
+    for (const auto& imagePair : imagePairs) {
+        if (imagePair.first < 0 || imagePair.first >= numImages || imagePair.second < 0 ||
+            imagePair.second >= numImages) {
+            CV_Error(cv::Error::StsOutOfRange, "image index out of range");
+        }
+    }
+
+    const int numPairs = imagePairs.size();
+    models.assign(numPairs, cv::Mat());
+    matchMasks.assign(numPairs, std::vector<char>());
+
+    // nested cv::parallel_for_ runs serially, so hypotheses of each pair are scored on the pair's thread
+    cv::parallel_for_(cv::Range(0, numPairs), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; ++i) {
+            models[i] = this->verify(keyPointsList[imagePairs[i].first], keyPointsList[imagePairs[i].second],
+                                     matchesList[i], matchMasks[i]);
+        }
+    });
+}
+}  // namespace _cv
+
+namespace
+{
+ProsacSampler::ProsacSampler(int numPoints, int sampleSize, int maxIterations, std::uint64_t seed)
+    : m_numPoints(numPoints)
+    , m_sampleSize(sampleSize)
+    , m_subsetSize(sampleSize)
+    , m_numIterations(0)
+    , m_tn(maxIterations)
+    , m_tnPrime(1)
+    , m_rng(seed)
+{
+    for (int i = 0; i < sampleSize; ++i) {
+        m_tn *= static_cast<double>(sampleSize - i) / (numPoints - i);
+    }
+}
+
+void ProsacSampler::sample(std::vector<int>& indices)
+{
+    ++m_numIterations;
+    if (m_numIterations > m_tnPrime && m_subsetSize < m_numPoints) {
+        double tnNext = m_tn * (m_subsetSize + 1) / (m_subsetSize + 1 - m_sampleSize);
+        m_tnPrime += std::ceil(tnNext - m_tn);
+        m_tn = tnNext;
+        ++m_subsetSize;
+    }
+
+    indices.clear();
+    if (m_tnPrime < m_numIterations) {
+        this->drawDistinct(m_subsetSize, m_sampleSize, indices);
+    } else {
+        // the newest (least confident) point of the current subset is always part of the sample
+        this->drawDistinct(m_subsetSize - 1, m_sampleSize - 1, indices);
+        indices.emplace_back(m_subsetSize - 1);
+    }
+}
+
+void ProsacSampler::drawDistinct(int range, int count, std::vector<int>& indices)
+{
+    while (static_cast<int>(indices.size()) < count) {
+        int idx = m_rng.uniform(0, range);
+        if (std::find(indices.begin(), indices.end(), idx) == indices.end()) {
+            indices.emplace_back(idx);
+        }
+    }
+}
+
+int sampleSize(Model model)
+{
+    switch (model) {
+        case Model::HOMOGRAPHY:
+            return 4;
+        case Model::FUNDAMENTAL:
+            return 7;
+        case Model::ESSENTIAL:
+            return 5;
+        default:
+            throw std::runtime_error("unknown geometric model");
+    }
+}
+
+std::vector<cv::Matx33d> solveMinimal(Model model, const std::vector<cv::Point2f>& pts1,
+                                      const std::vector<cv::Point2f>& pts2)
+{
+    cv::Mat solutions;
+    switch (model) {
+        case Model::HOMOGRAPHY:
+            solutions = cv::getPerspectiveTransform(pts1, pts2);
+            break;
+        case Model::FUNDAMENTAL:
+            // up to 3 solutions stacked vertically
+            solutions = cv::findFundamentalMat(pts1, pts2, cv::FM_7POINT);
+            break;
+        case Model::ESSENTIAL:
+            // with exactly 5 points, all (up to 10) solutions of the 5-point solver are stacked vertically
+            solutions = cv::findEssentialMat(pts1, pts2, cv::Mat::eye(3, 3, CV_64F), cv::RANSAC, 0.999, 1.0);
+            break;
+    }
+
+    std::vector<cv::Matx33d> models;
+    if (solutions.empty() || solutions.cols != 3 || solutions.rows % 3 != 0) {
+        return models;
+    }
+    solutions.convertTo(solutions, CV_64F);
+
+    for (int i = 0; i < solutions.rows; i += 3) {
+        cv::Matx33d curModel = solutions.rowRange(i, i + 3);
+        if (!cv::checkRange(curModel)) {
+            continue;
+        }
+        if (model == Model::HOMOGRAPHY && std::abs(cv::determinant(curModel)) < 1e-10) {
+            continue;
+        }
+        models.emplace_back(curModel);
+    }
+
+    return models;
+}
+
+cv::Mat solveNonMinimal(Model model, const std::vector<cv::Point2f>& pts1, const std::vector<cv::Point2f>& pts2)
+{
+    switch (model) {
+        case Model::HOMOGRAPHY:
+            return cv::findHomography(pts1, pts2, 0);
+        case Model::FUNDAMENTAL:
+            if (pts1.size() < 8) {
+                return cv::Mat();
+            }
+            return cv::findFundamentalMat(pts1, pts2, cv::FM_8POINT);
+        default:
+            // the 5-point solver has no least squares counterpart in opencv, so keep the minimal solution
+            return cv::Mat();
+    }
+}
+
+void computeSquaredResiduals(Model model, const cv::Matx33d& m, const Correspondences& corrs, float* residuals)
+{
+    const int n = corrs.size();
+    const float* x1 = corrs.x1.data();
+    const float* y1 = corrs.y1.data();
+    const float* x2 = corrs.x2.data();
+    const float* y2 = corrs.y2.data();
+
+    const float m0 = m(0, 0), m1 = m(0, 1), m2 = m(0, 2);
+    const float m3 = m(1, 0), m4 = m(1, 1), m5 = m(1, 2);
+    const float m6 = m(2, 0), m7 = m(2, 1), m8 = m(2, 2);
+
+    // branch-free loops over contiguous arrays, left to the compiler to vectorize
+    if (model == Model::HOMOGRAPHY) {
+        // forward transfer error
+        for (int i = 0; i < n; ++i) {
+            float w = 1.f / (m6 * x1[i] + m7 * y1[i] + m8);
+            float dx = (m0 * x1[i] + m1 * y1[i] + m2) * w - x2[i];
+            float dy = (m3 * x1[i] + m4 * y1[i] + m5) * w - y2[i];
+            residuals[i] = dx * dx + dy * dy;
+        }
+        return;
+    }
+
+    // sampson distance
+    for (int i = 0; i < n; ++i) {
+        float fx0 = m0 * x1[i] + m1 * y1[i] + m2;
+        float fx1 = m3 * x1[i] + m4 * y1[i] + m5;
+        float fx2 = m6 * x1[i] + m7 * y1[i] + m8;
+        float ftx0 = m0 * x2[i] + m3 * y2[i] + m6;
+        float ftx1 = m1 * x2[i] + m4 * y2[i] + m7;
+        float d = x2[i] * fx0 + y2[i] * fx1 + fx2;
+        residuals[i] = d * d / (fx0 * fx0 + fx1 * fx1 + ftx0 * ftx0 + ftx1 * ftx1);
+    }
+}
+
+int countInliers(const float* residuals, int numResiduals, float sqThresh)
+{
+    int numInliers = 0;
+    for (int i = 0; i < numResiduals; ++i) {
+        numInliers += residuals[i] <= sqThresh;
+    }
+    return numInliers;
+}
+
+int updateNumIterations(double confidence, double inlierRatio, int sampleSize, int maxIterations)
+{
+    double num = std::log(1 - confidence);
+    double denom = std::log(1 - std::pow(inlierRatio, sampleSize));
+    if (denom >= 0 || -num >= maxIterations * (-denom)) {
+        return maxIterations;
+    }
+    return std::round(num / denom);
+}
+}  // namespace
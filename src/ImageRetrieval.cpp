@@ -0,0 +1,343 @@
+/**
+ * @file    ImageRetrieval.cpp
+ *
+ * @author  btran
+ *
+ */
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <set>
+
+#include <torch_cpp/ImageRetrieval.hpp>
+
+namespace _cv
+{
+class ImageRetrievalImpl : public ImageRetrieval
+{
+ public:
+    explicit ImageRetrievalImpl(const ImageRetrieval::Param& param);
+
+    void train(const std::vector<cv::Mat>& descriptorsList) final;
+
+    void save(const std::string& path) const final;
+
+    void computeGlobalDescriptor(cv::InputArray _descriptors, cv::OutputArray _globalDescriptor) const final;
+
+    int add(cv::InputArray _descriptors) final;
+
+    void query(cv::InputArray _descriptors, int k, CV_OUT std::vector<cv::DMatch>& candidates) const final;
+
+    void findCandidatePairs(int k, CV_OUT std::vector<std::pair<int, int>>& imagePairs) const final;
+
+    int size() const final
+    {
+        return m_database.rows;
+    }
+
+ private:
+    void load(const std::string& path);
+
+    void resetIndex();
+
+    cv::Mat computeVLAD(const cv::Mat& descriptors) const;
+
+    // pca projection (if trained) and l2 normalization of each row
+    cv::Mat project(const cv::Mat& vlads) const;
+
+    std::vector<int> nearestLists(const cv::Mat& globalDescriptor, int numLists) const;
+
+    void search(const cv::Mat& globalDescriptor, int k, std::vector<cv::DMatch>& candidates) const;
+
+ private:
+    ImageRetrieval::Param m_param;
+
+    cv::Mat m_vocabulary;  // numVisualWords x descriptor size
+    cv::Mat m_vocabularySqNorms;
+    cv::PCA m_pca;
+    cv::Mat m_coarseCentroids;  // numLists x global descriptor size, empty for a flat index
+
+    cv::Mat m_database;  // one global descriptor per row
+    std::vector<std::vector<int>> m_invertedLists;
+};
+
+cv::Ptr<ImageRetrieval> ImageRetrieval::create(const Param& param)
+{
+    return cv::makePtr<ImageRetrievalImpl>(param);
+}
+
+ImageRetrievalImpl::ImageRetrievalImpl(const ImageRetrieval::Param& param)
+    : m_param(param)
+{
+    if (m_param.numVisualWords <= 0) {
+        throw std::runtime_error("number of visual words must be more than 0");
+    }
+
+    if (m_param.numLists <= 0 || m_param.numProbes <= 0) {
+        throw std::runtime_error("number of inverted lists and probes must be more than 0");
+    }
+
+    if (m_param.maxTrainingDescriptors <= 0) {
+        throw std::runtime_error("max number of training descriptors must be more than 0");
+    }
+
+    if (!m_param.pathToVocabulary.empty()) {
+        this->load(m_param.pathToVocabulary);
+    }
+    this->resetIndex();
+}
+
+void ImageRetrievalImpl::train(const std::vector<cv::Mat>& descriptorsList)
+{
+    cv::Mat samples;
+    for (const auto& descriptors : descriptorsList) {
+        if (descriptors.empty()) {
+            continue;
+        }
+        if (descriptors.type() != CV_32F) {
+            CV_Error(cv::Error::StsBadArg, "descriptors have incorrect type (!=CV_32F)");
+        }
+        samples.push_back(descriptors);
+    }
+
+    if (samples.rows < m_param.numVisualWords) {
+        CV_Error(cv::Error::StsBadArg, "not enough descriptors to train the vocabulary");
+    }
+
+    if (samples.rows > m_param.maxTrainingDescriptors) {
+        std::vector<int> indices(samples.rows);
+        std::iota(indices.begin(), indices.end(), 0);
+        cv::RNG rng(2022);
+        cv::randShuffle(indices, 1, &rng);
+
+        cv::Mat subsamples(m_param.maxTrainingDescriptors, samples.cols, samples.type());
+        for (int i = 0; i < subsamples.rows; ++i) {
+            samples.row(indices[i]).copyTo(subsamples.row(i));
+        }
+        samples = subsamples;
+    }
+
+    const cv::TermCriteria criteria(cv::TermCriteria::EPS + cv::TermCriteria::COUNT, 100, 1e-4);
+    cv::Mat labels;
+    cv::kmeans(samples, m_param.numVisualWords, labels, criteria, 1, cv::KMEANS_PP_CENTERS, m_vocabulary);
+    cv::reduce(m_vocabulary.mul(m_vocabulary), m_vocabularySqNorms, 1, cv::REDUCE_SUM);
+
+    cv::Mat vlads;
+    for (const auto& descriptors : descriptorsList) {
+        vlads.push_back(this->computeVLAD(descriptors));
+    }
+
+    m_pca = cv::PCA();
+    if (m_param.globalDescriptorSize > 0 && m_param.globalDescriptorSize < vlads.cols) {
+        // pca keeps at most as many components as training images
+        if (vlads.rows < m_param.globalDescriptorSize) {
+            CV_Error(cv::Error::StsBadArg,
+                     "not enough training images for the pca dimension of the global descriptor");
+        }
+        m_pca = cv::PCA(vlads, cv::noArray(), cv::PCA::DATA_AS_ROW, m_param.globalDescriptorSize);
+    }
+    cv::Mat globalDescriptors = this->project(vlads);
+
+    m_coarseCentroids.release();
+    int numLists = std::min(m_param.numLists, globalDescriptors.rows);
+    if (numLists > 1) {
+        cv::kmeans(globalDescriptors, numLists, labels, criteria, 1, cv::KMEANS_PP_CENTERS, m_coarseCentroids);
+    }
+
+    this->resetIndex();
+}
+
+void ImageRetrievalImpl::save(const std::string& path) const
+{
+    cv::FileStorage fs(path, cv::FileStorage::WRITE);
+    if (!fs.isOpened()) {
+        CV_Error(cv::Error::StsError, "failed to open " + path);
+    }
+
+    fs << "vocabulary" << m_vocabulary;
+    fs << "pca_mean" << m_pca.mean;
+    fs << "pca_eigenvectors" << m_pca.eigenvectors;
+    fs << "pca_eigenvalues" << m_pca.eigenvalues;
+    fs << "coarse_centroids" << m_coarseCentroids;
+}
+
+void ImageRetrievalImpl::load(const std::string& path)
+{
+    cv::FileStorage fs(path, cv::FileStorage::READ);
+    if (!fs.isOpened()) {
+        throw std::runtime_error("failed to open " + path);
+    }
+
+    fs["vocabulary"] >> m_vocabulary;
+    fs["pca_mean"] >> m_pca.mean;
+    fs["pca_eigenvectors"] >> m_pca.eigenvectors;
+    fs["pca_eigenvalues"] >> m_pca.eigenvalues;
+    fs["coarse_centroids"] >> m_coarseCentroids;
+
+    if (m_vocabulary.empty() || m_vocabulary.type() != CV_32F) {
+        throw std::runtime_error("invalid vocabulary in " + path);
+    }
+    cv::reduce(m_vocabulary.mul(m_vocabulary), m_vocabularySqNorms, 1, cv::REDUCE_SUM);
+}
+
+void ImageRetrievalImpl::resetIndex()
+{
+    m_database.release();
+    m_invertedLists.assign(std::max(1, m_coarseCentroids.rows), std::vector<int>());
+}
+
+void ImageRetrievalImpl::computeGlobalDescriptor(cv::InputArray _descriptors, cv::OutputArray _globalDescriptor) const
+{
+    this->project(this->computeVLAD(_descriptors.getMat())).copyTo(_globalDescriptor);
+}
+
+int ImageRetrievalImpl::add(cv::InputArray _descriptors)
+{
+    cv::Mat globalDescriptor;
+    this->computeGlobalDescriptor(_descriptors, globalDescriptor);
+
+    int imageIdx = m_database.rows;
+    m_database.push_back(globalDescriptor);
+    m_invertedLists[this->nearestLists(globalDescriptor, 1)[0]].emplace_back(imageIdx);
+
+    return imageIdx;
+}
+
+void ImageRetrievalImpl::query(cv::InputArray _descriptors, int k, CV_OUT std::vector<cv::DMatch>& candidates) const
+{
+    cv::Mat globalDescriptor;
+    this->computeGlobalDescriptor(_descriptors, globalDescriptor);
+    this->search(globalDescriptor, k, candidates);
+}
+
+void ImageRetrievalImpl::findCandidatePairs(int k, CV_OUT std::vector<std::pair<int, int>>& imagePairs) const
+{
+    const int numImages = m_database.rows;
+    std::vector<std::vector<cv::DMatch>> neighborsList(numImages);
+    cv::parallel_for_(cv::Range(0, numImages), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; ++i) {
+            // one more for the image itself
+            this->search(m_database.row(i), k + 1, neighborsList[i]);
+        }
+    });
+
+    std::set<std::pair<int, int>> uniquePairs;
+    for (int i = 0; i < numImages; ++i) {
+        int numNeighbors = 0;
+        for (const auto& neighbor : neighborsList[i]) {
+            if (neighbor.trainIdx == i || numNeighbors == k) {
+                continue;
+            }
+            uniquePairs.emplace(std::min(i, neighbor.trainIdx), std::max(i, neighbor.trainIdx));
+            ++numNeighbors;
+        }
+    }
+    imagePairs.assign(uniquePairs.begin(), uniquePairs.end());
+}
+
+cv::Mat ImageRetrievalImpl::computeVLAD(const cv::Mat& descriptors) const
+{
+    if (m_vocabulary.empty()) {
+        CV_Error(cv::Error::StsError, "vocabulary is not trained");
+    }
+
+    if (!descriptors.empty() && (descriptors.type() != CV_32F || descriptors.cols != m_vocabulary.cols)) {
+        CV_Error(cv::Error::StsBadArg, "descriptors have incorrect type (!=CV_32F) or size");
+    }
+
+    const int numVisualWords = m_vocabulary.rows;
+    const int descriptorSize = m_vocabulary.cols;
+    cv::Mat vlad = cv::Mat::zeros(numVisualWords, descriptorSize, CV_32F);
+
+    if (!descriptors.empty()) {
+        // nearest visual word is the argmin of |c|^2 - 2 <d, c>
+        cv::Mat dists;
+        cv::gemm(descriptors, m_vocabulary, -2, cv::noArray(), 0, dists, cv::GEMM_2_T);
+
+        const float* sqNorms = m_vocabularySqNorms.ptr<float>();
+        for (int i = 0; i < descriptors.rows; ++i) {
+            const float* dist = dists.ptr<float>(i);
+            int nearest = 0;
+            float minDist = std::numeric_limits<float>::max();
+            for (int j = 0; j < numVisualWords; ++j) {
+                if (dist[j] + sqNorms[j] < minDist) {
+                    minDist = dist[j] + sqNorms[j];
+                    nearest = j;
+                }
+            }
+
+            float* residual = vlad.ptr<float>(nearest);
+            const float* descriptor = descriptors.ptr<float>(i);
+            const float* center = m_vocabulary.ptr<float>(nearest);
+            for (int j = 0; j < descriptorSize; ++j) {
+                residual[j] += descriptor[j] - center[j];
+            }
+        }
+    }
+
+    // intra-normalization, from Arandjelovic & Zisserman, "All about VLAD", CVPR 2013
+    for (int i = 0; i < numVisualWords; ++i) {
+        cv::Mat residual = vlad.row(i);
+        double norm = cv::norm(residual);
+        if (norm > 0) {
+            residual /= norm;
+        }
+    }
+
+    return vlad.reshape(1, 1);
+}
+
+cv::Mat ImageRetrievalImpl::project(const cv::Mat& vlads) const
+{
+    cv::Mat globalDescriptors = m_pca.eigenvectors.empty() ? vlads.clone() : m_pca.project(vlads);
+    for (int i = 0; i < globalDescriptors.rows; ++i) {
+        cv::Mat globalDescriptor = globalDescriptors.row(i);
+        double norm = cv::norm(globalDescriptor);
+        if (norm > 0) {
+            globalDescriptor /= norm;
+        }
+    }
+    return globalDescriptors;
+}
+
+std::vector<int> ImageRetrievalImpl::nearestLists(const cv::Mat& globalDescriptor, int numLists) const
+{
+    if (m_coarseCentroids.empty()) {
+        return {0};
+    }
+
+    std::vector<double> dists(m_coarseCentroids.rows);
+    for (int i = 0; i < m_coarseCentroids.rows; ++i) {
+        dists[i] = cv::norm(globalDescriptor, m_coarseCentroids.row(i), cv::NORM_L2SQR);
+    }
+
+    std::vector<int> listIndices(m_coarseCentroids.rows);
+    std::iota(listIndices.begin(), listIndices.end(), 0);
+    numLists = std::min<int>(numLists, listIndices.size());
+    std::partial_sort(listIndices.begin(), listIndices.begin() + numLists, listIndices.end(),
+                      [&dists](int i, int j) { return dists[i] < dists[j]; });
+    listIndices.resize(numLists);
+
+    return listIndices;
+}
+
+void ImageRetrievalImpl::search(const cv::Mat& globalDescriptor, int k, std::vector<cv::DMatch>& candidates) const
+{
+    candidates.clear();
+    if (k <= 0 || m_database.empty()) {
+        return;
+    }
+
+    for (int listIdx : this->nearestLists(globalDescriptor, m_param.numProbes)) {
+        for (int imageIdx : m_invertedLists[listIdx]) {
+            float similarity = globalDescriptor.dot(m_database.row(imageIdx));
+            candidates.emplace_back(0, imageIdx, 1 - similarity);
+        }
+    }
+
+    int numCandidates = std::min<int>(k, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + numCandidates, candidates.end());
+    candidates.resize(numCandidates);
+}
+}  // namespace _cv
@@ -0,0 +1,66 @@
+/**
+ * @file    InferenceEngine.cpp
+ *
+ * @author  btran
+ *
+ */
+
+#include "InferenceEngine.hpp"
+
+namespace _cv
+{
+Tensor Tensor::fromMat(const cv::Mat& mat, const std::vector<std::int64_t>& shape)
+{
+    if (mat.depth() != CV_32F && mat.depth() != CV_32S) {
+        CV_Error(cv::Error::StsBadArg, "tensor data has incorrect depth (!=CV_32F and !=CV_32S)");
+    }
+
+    Tensor tensor;
+    tensor.shape = shape;
+    tensor.data = mat.isContinuous() ? mat : mat.clone();
+
+    std::int64_t numel = 1;
+    for (auto dim : shape) {
+        numel *= dim;
+    }
+    if (numel != static_cast<std::int64_t>(tensor.data.total() * tensor.data.channels())) {
+        CV_Error(cv::Error::StsBadSize, "tensor shape and data size mismatch");
+    }
+
+    return tensor;
+}
+
+Tensor Tensor::fromFloats(const std::vector<float>& values)
+{
+    return Tensor::fromMat(cv::Mat(values, true), {static_cast<std::int64_t>(values.size())});
+}
+
+Tensor Tensor::fromInts(const std::vector<int>& values)
+{
+    return Tensor::fromMat(cv::Mat(values, true), {static_cast<std::int64_t>(values.size())});
+}
+
+cv::Ptr<InferenceEngine> InferenceEngine::create(const Param& param)
+{
+    if (param.pathToWeights.empty()) {
+        throw std::runtime_error("empty path to weights");
+    }
+
+    switch (param.backend) {
+        case InferenceBackend::TORCHSCRIPT:
+#if ENABLE_TORCH
+            return createTorchScriptEngine(param);
+#else
+            throw std::runtime_error("torch_cpp is built without torchscript backend");
+#endif
+        case InferenceBackend::ONNXRUNTIME:
+#if ENABLE_ONNXRUNTIME
+            return createOnnxRuntimeEngine(param);
+#else
+            throw std::runtime_error("torch_cpp is built without onnxruntime backend");
+#endif
+        default:
+            throw std::runtime_error("unknown inference backend");
+    }
+}
+}  // namespace _cv
@@ -0,0 +1,68 @@
+/**
+ * @file    InferenceEngine.hpp
+ *
+ * @author  btran
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include <torch_cpp/InferenceBackend.hpp>
+
+namespace _cv
+{
+/**
+ *  @brief dense tensor exchanged with the inference engines. data is continuous and holds the product of shape
+ *  elements, as CV_32F or CV_32S.
+ */
+struct Tensor {
+    // wrap a continuous mat without copy
+    static Tensor fromMat(const cv::Mat& mat, const std::vector<std::int64_t>& shape);
+
+    // 1-d tensors
+    static Tensor fromFloats(const std::vector<float>& values);
+    static Tensor fromInts(const std::vector<int>& values);
+
+    std::vector<std::int64_t> shape;
+    cv::Mat data;
+};
+
+using NamedTensors = std::unordered_map<std::string, Tensor>;
+
+class InferenceEngine
+{
+ public:
+    struct Param {
+        InferenceBackend backend = InferenceBackend::TORCHSCRIPT;
+        std::string pathToWeights = "";
+        int gpuIdx = -1;  // use gpu >= 0 to specify cuda device
+    };
+
+    static cv::Ptr<InferenceEngine> create(const Param& param);
+
+    virtual ~InferenceEngine() = default;
+
+    /**
+     *  @brief run the model. inputs the model does not take are ignored. list outputs of torchscript models are
+     *  returned as their first element, as models are run with a batch size of 1.
+     */
+    virtual NamedTensors forward(const NamedTensors& inputs) = 0;
+
+    virtual std::string device() const = 0;
+};
+
+#if ENABLE_TORCH
+cv::Ptr<InferenceEngine> createTorchScriptEngine(const InferenceEngine::Param& param);
+#endif
+
+#if ENABLE_ONNXRUNTIME
+cv::Ptr<InferenceEngine> createOnnxRuntimeEngine(const InferenceEngine::Param& param);
+#endif
+}  // namespace _cv
@@ -0,0 +1,166 @@
+/**
+ * @file    OnnxRuntimeEngine.cpp
+ *
+ * @author  btran
+ *
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include <onnxruntime_cxx_api.h>
+
+#include <torch_cpp/Utility.hpp>
+
+#include "InferenceEngine.hpp"
+
+namespace
+{
+_cv::Tensor fromOrtValue(const Ort::Value& value);
+}  // namespace
+
+namespace _cv
+{
+class OnnxRuntimeEngine : public InferenceEngine
+{
+ public:
+    explicit OnnxRuntimeEngine(const InferenceEngine::Param& param);
+
+    NamedTensors forward(const NamedTensors& inputs) final;
+
+    std::string device() const final
+    {
+        return "cpu";
+    }
+
+ private:
+    InferenceEngine::Param m_param;
+    Ort::Env m_env;
+    Ort::Session m_session;
+    Ort::MemoryInfo m_memoryInfo;
+
+    std::vector<std::string> m_inputNames;
+    std::vector<ONNXTensorElementDataType> m_inputTypes;
+    std::vector<std::string> m_outputNames;
+};
+
+cv::Ptr<InferenceEngine> createOnnxRuntimeEngine(const InferenceEngine::Param& param)
+{
+    return cv::makePtr<OnnxRuntimeEngine>(param);
+}
+
+OnnxRuntimeEngine::OnnxRuntimeEngine(const InferenceEngine::Param& param)
+    : m_param(param)
+    , m_env(ORT_LOGGING_LEVEL_WARNING, "torch_cpp")
+    , m_session(nullptr)
+    , m_memoryInfo(Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault))
+{
+    if (m_param.gpuIdx >= 0) {
+        DEBUG_LOG("onnxruntime backend only supports cpu so fall back to cpu...");
+        m_param.gpuIdx = -1;
+    }
+
+    try {
+        Ort::SessionOptions sessionOptions;
+        sessionOptions.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+        m_session = Ort::Session(m_env, m_param.pathToWeights.c_str(), sessionOptions);
+    } catch (const std::exception& e) {
+        INFO_LOG("%s", e.what());
+        exit(1);
+    }
+
+    Ort::AllocatorWithDefaultOptions allocator;
+    for (std::size_t i = 0; i < m_session.GetInputCount(); ++i) {
+        m_inputNames.emplace_back(m_session.GetInputNameAllocated(i, allocator).get());
+        m_inputTypes.emplace_back(m_session.GetInputTypeInfo(i).GetTensorTypeAndShapeInfo().GetElementType());
+    }
+    for (std::size_t i = 0; i < m_session.GetOutputCount(); ++i) {
+        m_outputNames.emplace_back(m_session.GetOutputNameAllocated(i, allocator).get());
+    }
+}
+
+NamedTensors OnnxRuntimeEngine::forward(const NamedTensors& inputs)
+{
+    std::vector<const char*> inputNames, outputNames;
+    std::vector<Ort::Value> inputValues;
+    // int64 copies of integer inputs, alive until the session is run
+    std::vector<std::vector<std::int64_t>> int64Buffers;
+    int64Buffers.reserve(m_inputNames.size());
+
+    for (std::size_t i = 0; i < m_inputNames.size(); ++i) {
+        auto it = inputs.find(m_inputNames[i]);
+        if (it == inputs.end()) {
+            throw std::runtime_error("missing input " + m_inputNames[i]);
+        }
+        const Tensor& tensor = it->second;
+        const std::size_t numel = tensor.data.total();
+
+        switch (m_inputTypes[i]) {
+            case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT:
+                if (tensor.data.depth() != CV_32F) {
+                    throw std::runtime_error("input " + m_inputNames[i] + " must be float");
+                }
+                inputValues.emplace_back(Ort::Value::CreateTensor<float>(
+                    m_memoryInfo, reinterpret_cast<float*>(tensor.data.data), numel, tensor.shape.data(),
+                    tensor.shape.size()));
+                break;
+            case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64: {
+                cv::Mat int32Data;
+                tensor.data.convertTo(int32Data, CV_32S);
+                int64Buffers.emplace_back(int32Data.ptr<int>(), int32Data.ptr<int>() + numel);
+                inputValues.emplace_back(Ort::Value::CreateTensor<std::int64_t>(
+                    m_memoryInfo, int64Buffers.back().data(), numel, tensor.shape.data(), tensor.shape.size()));
+                break;
+            }
+            default:
+                throw std::runtime_error("unsupported type of input " + m_inputNames[i]);
+        }
+        inputNames.emplace_back(m_inputNames[i].c_str());
+    }
+
+    for (const auto& outputName : m_outputNames) {
+        outputNames.emplace_back(outputName.c_str());
+    }
+
+    auto outputValues = m_session.Run(Ort::RunOptions{nullptr}, inputNames.data(), inputValues.data(),
+                                      inputValues.size(), outputNames.data(), outputNames.size());
+
+    NamedTensors outputs;
+    for (std::size_t i = 0; i < m_outputNames.size(); ++i) {
+        outputs.emplace(m_outputNames[i], ::fromOrtValue(outputValues[i]));
+    }
+
+    return outputs;
+}
+}  // namespace _cv
+
+namespace
+{
+_cv::Tensor fromOrtValue(const Ort::Value& value)
+{
+    auto info = value.GetTensorTypeAndShapeInfo();
+    const int numel = info.GetElementCount();
+
+    _cv::Tensor tensor;
+    tensor.shape = info.GetShape();
+
+    switch (info.GetElementType()) {
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT:
+            tensor.data = cv::Mat(1, numel, CV_32F);
+            if (numel > 0) {
+                std::memcpy(tensor.data.data, value.GetTensorData<float>(), numel * sizeof(float));
+            }
+            break;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64: {
+            tensor.data = cv::Mat(1, numel, CV_32S);
+            const std::int64_t* src = value.GetTensorData<std::int64_t>();
+            std::copy(src, src + numel, tensor.data.ptr<int>());
+            break;
+        }
+        default:
+            throw std::runtime_error("unsupported output type");
+    }
+
+    return tensor;
+}
+}  // namespace
@@ -5,12 +5,11 @@
  *
  */
 
-#include <torch/script.h>
-#include <torch/torch.h>
-
 #include <torch_cpp/SuperGlue.hpp>
 #include <torch_cpp/Utility.hpp>
 
+#include "InferenceEngine.hpp"
+
 namespace _cv
 {
 class SuperGlueImpl : public SuperGlue
@@ -25,8 +24,7 @@ class SuperGlueImpl : public SuperGlue
 
  private:
     SuperGlue::Param m_param;
-    torch::Device m_device;
-    mutable torch::jit::script::Module m_module;
+    cv::Ptr<InferenceEngine> m_engine;
 };
 
 cv::Ptr<SuperGlue> SuperGlue::create(const Param& param)
@@ -36,34 +34,13 @@ cv::Ptr<SuperGlue> SuperGlue::create(const Param& param)
 
 SuperGlueImpl::SuperGlueImpl(const SuperGlue::Param& param)
     : m_param(param)
-    , m_device(torch::kCPU)
 {
-    if (m_param.pathToWeights.empty()) {
-        throw std::runtime_error("empty path to weights");
-    }
-    try {
-        m_module = torch::jit::load(m_param.pathToWeights);
-    } catch (const std::exception& e) {
-        INFO_LOG("%s", e.what());
-        exit(1);
-    }
-
-#if ENABLE_GPU
-    if (!torch::cuda::is_available() && m_param.gpuIdx >= 0) {
-        DEBUG_LOG("torch does not recognize cuda device so fall back to cpu...");
-        m_param.gpuIdx = -1;
-    }
-#else
-    DEBUG_LOG("gpu option is not enabled...");
-    m_param.gpuIdx = -1;
-#endif
-
-    if (m_param.gpuIdx >= 0) {
-        torch::NoGradGuard no_grad;
-        m_device = torch::Device(torch::kCUDA, m_param.gpuIdx);
-    }
-    m_module.eval();
-    m_module.to(m_device);
+    InferenceEngine::Param engineParam;
+    engineParam.backend = m_param.backend;
+    engineParam.pathToWeights = m_param.pathToWeights;
+    engineParam.gpuIdx = m_param.gpuIdx;
+    m_engine = InferenceEngine::create(engineParam);
+    DEBUG_LOG("use device: %s", m_engine->device().c_str());
 }
 
 void SuperGlueImpl::match(cv::InputArray _queryDescriptors, const std::vector<cv::KeyPoint>& queryKeypoints,
@@ -71,74 +48,55 @@ void SuperGlueImpl::match(cv::InputArray _queryDescriptors, const std::vector<cv
                           const std::vector<cv::KeyPoint>& trainKeypoints, const cv::Size& trainSize,
                           CV_OUT std::vector<cv::DMatch>& matches) const
 {
-    torch::Dict<std::string, torch::Tensor> data;
-    data.insert(
-        "image0_shape",
-        torch::from_blob(
-            std::vector<float>{1, 1, static_cast<float>(querySize.height), static_cast<float>(querySize.width)}.data(),
-            {4}, torch::kFloat)
-            .clone());
-    data.insert(
-        "image1_shape",
-        torch::from_blob(
-            std::vector<float>{1, 1, static_cast<float>(trainSize.height), static_cast<float>(trainSize.width)}.data(),
-            {4}, torch::kFloat)
-            .clone());
-    data.insert("match_threshold",
-                torch::from_blob(std::vector<float>{m_param.matchThreshold}.data(), {1}, torch::kFloat).clone());
-
-    int numQueryKeyPoints = queryKeypoints.size();
-    int numTrainKeyPoints = trainKeypoints.size();
-
-    std::vector<torch::Tensor> descriptorsList = {
-        torch::from_blob(_queryDescriptors.getMat().ptr<float>(),
-                         {1, numQueryKeyPoints, _queryDescriptors.getMat().cols}, torch::kFloat),
-        torch::from_blob(_trainDescriptors.getMat().ptr<float>(),
-                         {1, numTrainKeyPoints, _trainDescriptors.getMat().cols}, torch::kFloat)};
-
-    for (int i = 0; i < 2; ++i) {
-        descriptorsList[i] = descriptorsList[i].permute({0, 2, 1}).contiguous();
-        data.insert("descriptors" + std::to_string(i), std::move(descriptorsList[i]).to(m_device));
+    // nothing to match, and the onnx model can not reduce over zero keypoints
+    if (queryKeypoints.empty() || trainKeypoints.empty()) {
+        return;
     }
 
-    std::vector<torch::Tensor> keyPointsList = {torch::zeros({1, numQueryKeyPoints, 2}),
-                                                torch::zeros({1, numTrainKeyPoints, 2})};
-    std::vector<torch::Tensor> scoresList = {torch::zeros({1, numQueryKeyPoints}),
-                                             torch::zeros({1, numTrainKeyPoints})};
+    NamedTensors inputs;
+    inputs.emplace("image0_shape", Tensor::fromFloats({1, 1, static_cast<float>(querySize.height),
+                                                       static_cast<float>(querySize.width)}));
+    inputs.emplace("image1_shape", Tensor::fromFloats({1, 1, static_cast<float>(trainSize.height),
+                                                       static_cast<float>(trainSize.width)}));
+    inputs.emplace("match_threshold", Tensor::fromFloats({m_param.matchThreshold}));
 
-    for (int i = 0; i < numQueryKeyPoints; ++i) {
-        keyPointsList[0][0][i][0] = queryKeypoints[i].pt.y;
-        keyPointsList[0][0][i][1] = queryKeypoints[i].pt.x;
-        scoresList[0][0][i] = queryKeypoints[i].response;
-    }
-
-    for (int i = 0; i < numTrainKeyPoints; ++i) {
-        keyPointsList[1][0][i][0] = trainKeypoints[i].pt.y;
-        keyPointsList[1][0][i][1] = trainKeypoints[i].pt.x;
-        scoresList[1][0][i] = trainKeypoints[i].response;
-    }
+    const std::vector<const std::vector<cv::KeyPoint>*> keyPointsList = {&queryKeypoints, &trainKeypoints};
+    const std::vector<cv::Mat> descriptorsList = {_queryDescriptors.getMat(), _trainDescriptors.getMat()};
 
     for (int i = 0; i < 2; ++i) {
-        data.insert("keypoints" + std::to_string(i), std::move(keyPointsList[i]).to(m_device));
-        data.insert("scores" + std::to_string(i), std::move(scoresList[i]).to(m_device));
+        const auto& curKeyPoints = *keyPointsList[i];
+        const std::int64_t numKeyPoints = curKeyPoints.size();
+        const std::string suffix = std::to_string(i);
+
+        inputs.emplace("descriptors" + suffix,
+                       Tensor::fromMat(descriptorsList[i].t(), {1, descriptorsList[i].cols, numKeyPoints}));
+
+        // keypoints as (y, x), the order the scripted model normalizes with
+        cv::Mat keyPoints(numKeyPoints, 2, CV_32F);
+        cv::Mat scores(1, numKeyPoints, CV_32F);
+        for (int j = 0; j < numKeyPoints; ++j) {
+            keyPoints.ptr<float>(j)[0] = curKeyPoints[j].pt.y;
+            keyPoints.ptr<float>(j)[1] = curKeyPoints[j].pt.x;
+            scores.ptr<float>()[j] = curKeyPoints[j].response;
+        }
+        inputs.emplace("keypoints" + suffix, Tensor::fromMat(keyPoints, {1, numKeyPoints, 2}));
+        inputs.emplace("scores" + suffix, Tensor::fromMat(scores, {1, numKeyPoints}));
     }
 
-    torch::Tensor matches0;
-    {
-        auto outputs =
-            c10::impl::toTypedDict<std::string, torch::Tensor>(m_module.forward({std::move(data)}).toGenericDict());
-        matches0 = outputs.at("matches0");
-        matches0 = matches0.detach().cpu();
-    }
+    NamedTensors outputs = m_engine->forward(inputs);
+    const int* matches0 = outputs.at("matches0").data.ptr<int>();
+    const float* matchingScores0 = outputs.at("matching_scores0").data.ptr<float>();
 
+    const int numQueryKeyPoints = queryKeypoints.size();
     for (int i = 0; i < numQueryKeyPoints; ++i) {
-        if (matches0[0][i].item<std::int64_t>() < 0) {
+        if (matches0[i] < 0) {
             continue;
         }
         cv::DMatch match;
         match.imgIdx = 0;
         match.queryIdx = i;
-        match.trainIdx = matches0[0][i].item<std::int64_t>();
+        match.trainIdx = matches0[i];
+        match.distance = 1 - matchingScores0[i];
 
         matches.emplace_back(match);
     }
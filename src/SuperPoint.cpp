@@ -5,17 +5,34 @@
  *
  */
 
-#include <memory>
-
-#include <torch/script.h>
-#include <torch/torch.h>
+#include <cstring>
+#include <limits>
+#include <utility>
 
 #include <torch_cpp/SuperPoint.hpp>
 #include <torch_cpp/Utility.hpp>
 
+#include "InferenceEngine.hpp"
+
 namespace
 {
-cv::Mat copyRows(const cv::Mat& src, const std::vector<int>& indices);
+// superpoint predicts one keypoint per cell of 8x8 pixels
+constexpr int CELL_SIZE = 8;
+
+// context kept around each region of the mask so that the crop's keypoints and descriptors stay close to the ones
+// computed on the whole frame
+constexpr int CROP_MARGIN = 16;
+
+// run the whole frame when the crops cover more than this ratio of it
+constexpr float MAX_CROP_AREA_RATIO = 0.75;
+
+bool isSameMat(const cv::Mat& lhs, const cv::Mat& rhs);
+
+/**
+ *  @brief crops aligned to the cells of superpoint around the connected regions of the mask. empty if the mask has no
+ *  nonzero pixel, the whole frame if the crops would cover most of it.
+ */
+std::vector<cv::Rect> computeCrops(const cv::Mat& mask, int margin, int maxNumCrops);
 }  // namespace
 
 namespace _cv
@@ -38,10 +55,17 @@ class SuperPointImpl : public SuperPoint
         return CV_32F;
     }
 
+ private:
+    // resize the mask to the network input size and compute its crops, only when it differs from the previous one
+    void updateMask(const cv::Mat& mask);
+
  private:
     SuperPoint::Param m_param;
-    torch::Device m_device;
-    torch::jit::script::Module m_module;
+    cv::Ptr<InferenceEngine> m_engine;
+
+    cv::Mat m_mask;
+    cv::Mat m_resizedMask;
+    std::vector<cv::Rect> m_crops;
 };
 
 cv::Ptr<SuperPoint> SuperPoint::create(const Param& param)
@@ -51,42 +75,21 @@ cv::Ptr<SuperPoint> SuperPoint::create(const Param& param)
 
 SuperPointImpl::SuperPointImpl(const SuperPoint::Param& param)
     : m_param(param)
-    , m_device(torch::kCPU)
 {
     if (m_param.imageHeight <= 0 || m_param.imageWidth <= 0) {
         throw std::runtime_error("dimension must be more than 0");
     }
 
-    if (m_param.pathToWeights.empty()) {
-        throw std::runtime_error("empty path to weights");
-    }
-    try {
-        m_module = torch::jit::load(m_param.pathToWeights);
-    } catch (const std::exception& e) {
-        INFO_LOG("%s", e.what());
-        exit(1);
-    }
-
-#if ENABLE_GPU
-    if (!torch::cuda::is_available() && m_param.gpuIdx >= 0) {
-        DEBUG_LOG("torch does not recognize cuda device so fall back to cpu...");
-        m_param.gpuIdx = -1;
-    }
-#else
-    DEBUG_LOG("gpu option is not enabled...");
-    m_param.gpuIdx = -1;
-#endif
-
-    if (m_param.gpuIdx >= 0) {
-        torch::NoGradGuard no_grad;
-        m_device = torch::Device(torch::kCUDA, m_param.gpuIdx);
+    if (m_param.cropToMask && m_param.maxNumCrops <= 0) {
+        throw std::runtime_error("maxNumCrops must be more than 0");
     }
-    DEBUG_LOG("use device: %s", m_device.str().c_str());
-    m_module.eval();
 
-    if (!m_device.is_cpu()) {
-        m_module.to(m_device);
-    }
+    InferenceEngine::Param engineParam;
+    engineParam.backend = m_param.backend;
+    engineParam.pathToWeights = m_param.pathToWeights;
+    engineParam.gpuIdx = m_param.gpuIdx;
+    m_engine = InferenceEngine::create(engineParam);
+    DEBUG_LOG("use device: %s", m_engine->device().c_str());
 }
 
 void SuperPointImpl::detectAndCompute(cv::InputArray _image, cv::InputArray _mask, std::vector<cv::KeyPoint>& keyPoints,
@@ -103,89 +106,178 @@ void SuperPointImpl::detectAndCompute(cv::InputArray _image, cv::InputArray _mas
         CV_Error(cv::Error::StsBadArg, "mask has incorrect type (!=CV_8UC1)");
     }
 
-    torch::Dict<std::string, std::vector<torch::Tensor>> outputs;
-    {
+    if (!mask.empty()) {
+        this->updateMask(mask);
+    }
+
+    const cv::Rect frame(0, 0, m_param.imageWidth, m_param.imageHeight);
+    const std::vector<cv::Rect> crops =
+        (m_param.cropToMask && !mask.empty()) ? m_crops : std::vector<cv::Rect>{frame};
+
+    // crops have different shapes so they are run one after another instead of as a batch
+    std::vector<NamedTensors> outputsList;
+    outputsList.reserve(crops.size());
+    if (!crops.empty()) {
         cv::Mat buffer;
-        cv::resize(image, buffer, cv::Size(m_param.imageWidth, m_param.imageHeight), 0, 0, cv::INTER_CUBIC);
+        cv::resize(image, buffer, frame.size(), 0, 0, cv::INTER_CUBIC);
         buffer.convertTo(buffer, CV_32FC1, 1 / 255.);
 
-        auto x = torch::from_blob(buffer.ptr<float>(), {1, 1, m_param.imageHeight, m_param.imageWidth}, torch::kFloat);
-        x = x.set_requires_grad(false);
+        for (const cv::Rect& crop : crops) {
+            NamedTensors inputs;
+            inputs.emplace("image", Tensor::fromMat(buffer(crop), {1, 1, crop.height, crop.width}));
+            inputs.emplace("keypoint_threshold", Tensor::fromFloats({m_param.confidenceThresh}));
+            inputs.emplace("remove_borders", Tensor::fromInts({m_param.borderRemove}));
+            if (m_param.distThresh > 0) {
+                inputs.emplace("nms_radius", Tensor::fromInts({m_param.distThresh}));
+            }
 
-        if (!m_device.is_cpu()) {
-            x = x.to(m_device);
-        }
-        torch::Dict<std::string, torch::Tensor> data;
-        data.insert("image", std::move(x));
-        data.insert("keypoint_threshold",
-                    torch::from_blob(std::vector<float>{m_param.confidenceThresh}.data(), {1}, torch::kFloat).clone());
-        data.insert(
-            "remove_borders",
-            torch::from_blob(std::vector<std::int64_t>{m_param.borderRemove}.data(), {1}, torch::kInt64).clone());
-        if (m_param.distThresh > 0) {
-            data.insert(
-                "nms_radius",
-                torch::from_blob(std::vector<std::int64_t>{m_param.distThresh}.data(), {1}, torch::kInt64).clone());
+            outputsList.emplace_back(m_engine->forward(inputs));
         }
-
-        outputs =
-            c10::impl::toTypedDict<std::string, std::vector<torch::Tensor>>(m_module.forward({data}).toGenericDict());
-    }
-
-    // preparing mask
-    if (!mask.empty()) {
-        cv::resize(mask, mask, cv::Size(m_param.imageWidth, m_param.imageHeight), 0, 0, cv::INTER_NEAREST);
     }
 
     {
         keyPoints.clear();
-        auto keyPointsT = std::move(outputs.at("keypoints")[0]);  // y, x
-        auto scoresT = std::move(outputs.at("scores")[0]);
-        auto descriptorsT = std::move(outputs.at("descriptors")[0]);  // 256 x num_keypoints
-        descriptorsT = descriptorsT.permute({1, 0}).contiguous();
-
-        if (!m_device.is_cpu()) {
-            keyPointsT = keyPointsT.detach().cpu();
-            scoresT = scoresT.detach().cpu();
-            descriptorsT = descriptorsT.detach().cpu();
+
+        // (crop index, keypoint index in the crop) of the unmasked keypoints
+        std::vector<std::pair<int, int>> keepIndices;
+        for (std::size_t c = 0; c < crops.size(); ++c) {
+            const Tensor& keyPointsT = outputsList[c].at("keypoints");  // num_keypoints x 2 (x, y)
+            const Tensor& scoresT = outputsList[c].at("scores");        // num_keypoints
+
+            const int numKeyPoints = keyPointsT.shape[0];
+            const float* keyPointsPtr = keyPointsT.data.ptr<float>();
+            const float* scoresPtr = scoresT.data.ptr<float>();
+
+            for (int i = 0; i < numKeyPoints; ++i) {
+                int x = keyPointsPtr[2 * i] + crops[c].x;
+                int y = keyPointsPtr[2 * i + 1] + crops[c].y;
+                if (!mask.empty() && m_resizedMask.ptr<uchar>(y)[x] == 0) {
+                    continue;
+                }
+                cv::KeyPoint newKeyPoint;
+                newKeyPoint.pt.x = x * static_cast<float>(image.cols) / m_param.imageWidth;
+                newKeyPoint.pt.y = y * static_cast<float>(image.rows) / m_param.imageHeight;
+                newKeyPoint.response = scoresPtr[i];
+                keyPoints.emplace_back(std::move(newKeyPoint));
+                keepIndices.emplace_back(c, i);
+            }
         }
 
-        int numKeyPoints = keyPointsT.sizes()[0];
-        cv::Mat descriptors = cv::Mat(cv::Size(256, numKeyPoints), CV_32F);
-        std::memcpy(descriptors.ptr<float>(), descriptorsT.data_ptr<float>(), sizeof(float) * descriptorsT.numel());
-
-        std::vector<int> keepIndices;
-        keepIndices.reserve(numKeyPoints);
-        for (int i = 0; i < numKeyPoints; ++i) {
-            int y = keyPointsT[i][1].item<float>();
-            int x = keyPointsT[i][0].item<float>();
-            if (!mask.empty() && mask.ptr<uchar>(y)[x] == 0) {
-                continue;
+        // transpose and keep the descriptors of the unmasked keypoints in one pass
+        const int descriptorSize = this->descriptorSize();
+        _descriptors.create(cv::Size(descriptorSize, keepIndices.size()), CV_32F);
+        cv::Mat descriptors = _descriptors.getMat();
+        for (std::size_t i = 0; i < keepIndices.size(); ++i) {
+            const Tensor& descriptorsT = outputsList[keepIndices[i].first].at("descriptors");  // 256 x num_keypoints
+            const int numKeyPoints = descriptorsT.shape[1];
+            const float* descriptorsPtr = descriptorsT.data.ptr<float>();
+            float* row = descriptors.ptr<float>(i);
+            for (int j = 0; j < descriptorSize; ++j) {
+                row[j] = descriptorsPtr[j * numKeyPoints + keepIndices[i].second];
             }
-            cv::KeyPoint newKeyPoint;
-            newKeyPoint.pt.x = x * static_cast<float>(image.cols) / m_param.imageWidth;
-            newKeyPoint.pt.y = y * static_cast<float>(image.rows) / m_param.imageHeight;
-            newKeyPoint.response = scoresT[i].item<float>();
-            keyPoints.emplace_back(std::move(newKeyPoint));
-            keepIndices.emplace_back(i);
         }
+    }
+}
+
+void SuperPointImpl::updateMask(const cv::Mat& mask)
+{
+    if (::isSameMat(mask, m_mask)) {
+        return;
+    }
 
-        _descriptors.create(cv::Size(256, keepIndices.size()), CV_32F);
-        std::memcpy(_descriptors.getMat().ptr<float>(), ::copyRows(descriptors, keepIndices).clone().ptr<float>(),
-                    sizeof(float) * keepIndices.size() * 256);
+    mask.copyTo(m_mask);
+    cv::resize(mask, m_resizedMask, cv::Size(m_param.imageWidth, m_param.imageHeight), 0, 0, cv::INTER_NEAREST);
+    if (m_param.cropToMask) {
+        m_crops = ::computeCrops(m_resizedMask, CROP_MARGIN + m_param.borderRemove, m_param.maxNumCrops);
     }
 }
 }  // namespace _cv
 
 namespace
 {
-cv::Mat copyRows(const cv::Mat& src, const std::vector<int>& indices)
+bool isSameMat(const cv::Mat& lhs, const cv::Mat& rhs)
 {
-    int newNumRows = indices.size();
-    cv::Mat dst(0, newNumRows, src.type());
-    for (int i = 0; i < newNumRows; ++i) {
-        dst.push_back(src.row(indices[i]));
+    if (lhs.size() != rhs.size() || lhs.type() != rhs.type()) {
+        return false;
+    }
+
+    const std::size_t rowSize = lhs.cols * lhs.elemSize();
+    for (int i = 0; i < lhs.rows; ++i) {
+        if (std::memcmp(lhs.ptr(i), rhs.ptr(i), rowSize) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<cv::Rect> computeCrops(const cv::Mat& mask, int margin, int maxNumCrops)
+{
+    const cv::Rect frame(0, 0, mask.cols, mask.rows);
+
+    // work on the grid of cells so that the crops are aligned to the same cells as the whole frame
+    const cv::Size gridSize((mask.cols + CELL_SIZE - 1) / CELL_SIZE, (mask.rows + CELL_SIZE - 1) / CELL_SIZE);
+    cv::Mat grid = cv::Mat::zeros(gridSize, CV_8UC1);
+    for (int y = 0; y < mask.rows; ++y) {
+        const uchar* maskRow = mask.ptr<uchar>(y);
+        uchar* gridRow = grid.ptr<uchar>(y / CELL_SIZE);
+        for (int x = 0; x < mask.cols; ++x) {
+            if (maskRow[x] != 0) {
+                gridRow[x / CELL_SIZE] = 255;
+            }
+        }
+    }
+
+    cv::Mat labels, stats, centroids;
+    const int numLabels = cv::connectedComponentsWithStats(grid, labels, stats, centroids, 8, CV_32S);
+
+    const int cellMargin = (margin + CELL_SIZE - 1) / CELL_SIZE;
+    std::vector<cv::Rect> crops;
+    for (int i = 1; i < numLabels; ++i) {
+        const int* stat = stats.ptr<int>(i);
+        cv::Rect crop(stat[cv::CC_STAT_LEFT] - cellMargin, stat[cv::CC_STAT_TOP] - cellMargin,
+                      stat[cv::CC_STAT_WIDTH] + 2 * cellMargin, stat[cv::CC_STAT_HEIGHT] + 2 * cellMargin);
+        crops.emplace_back(cv::Rect(crop.x * CELL_SIZE, crop.y * CELL_SIZE, crop.width * CELL_SIZE,
+                                    crop.height * CELL_SIZE) &
+                           frame);
     }
-    return dst;
+
+    // merge overlapping crops, then the pairs whose union adds the least area until there are at most maxNumCrops
+    while (true) {
+        int bestI = -1, bestJ = -1;
+        int bestAddedArea = std::numeric_limits<int>::max();
+        for (std::size_t i = 0; i < crops.size() && bestAddedArea > 0; ++i) {
+            for (std::size_t j = i + 1; j < crops.size(); ++j) {
+                if ((crops[i] & crops[j]).area() > 0) {
+                    bestI = i;
+                    bestJ = j;
+                    bestAddedArea = 0;
+                    break;
+                }
+
+                int addedArea = (crops[i] | crops[j]).area() - crops[i].area() - crops[j].area();
+                if (addedArea < bestAddedArea) {
+                    bestI = i;
+                    bestJ = j;
+                    bestAddedArea = addedArea;
+                }
+            }
+        }
+
+        if (bestI < 0 || (bestAddedArea > 0 && static_cast<int>(crops.size()) <= maxNumCrops)) {
+            break;
+        }
+        crops[bestI] |= crops[bestJ];
+        crops.erase(crops.begin() + bestJ);
+    }
+
+    int cropArea = 0;
+    for (const cv::Rect& crop : crops) {
+        cropArea += crop.area();
+    }
+    if (cropArea > MAX_CROP_AREA_RATIO * frame.area()) {
+        return {frame};
+    }
+
+    return crops;
 }
 }  // namespace
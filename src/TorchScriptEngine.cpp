@@ -0,0 +1,133 @@
+/**
+ * @file    TorchScriptEngine.cpp
+ *
+ * @author  btran
+ *
+ */
+
+#include <cstring>
+
+#include <torch/script.h>
+#include <torch/torch.h>
+
+#include <torch_cpp/Utility.hpp>
+
+#include "InferenceEngine.hpp"
+
+namespace
+{
+torch::Tensor toTorchTensor(const _cv::Tensor& tensor);
+
+_cv::Tensor fromTorchTensor(torch::Tensor tensor);
+}  // namespace
+
+namespace _cv
+{
+class TorchScriptEngine : public InferenceEngine
+{
+ public:
+    explicit TorchScriptEngine(const InferenceEngine::Param& param);
+
+    NamedTensors forward(const NamedTensors& inputs) final;
+
+    std::string device() const final
+    {
+        return m_device.str();
+    }
+
+ private:
+    InferenceEngine::Param m_param;
+    torch::Device m_device;
+    torch::jit::script::Module m_module;
+};
+
+cv::Ptr<InferenceEngine> createTorchScriptEngine(const InferenceEngine::Param& param)
+{
+    return cv::makePtr<TorchScriptEngine>(param);
+}
+
+TorchScriptEngine::TorchScriptEngine(const InferenceEngine::Param& param)
+    : m_param(param)
+    , m_device(torch::kCPU)
+{
+    try {
+        m_module = torch::jit::load(m_param.pathToWeights);
+    } catch (const std::exception& e) {
+        INFO_LOG("%s", e.what());
+        exit(1);
+    }
+
+#if ENABLE_GPU
+    if (!torch::cuda::is_available() && m_param.gpuIdx >= 0) {
+        DEBUG_LOG("torch does not recognize cuda device so fall back to cpu...");
+        m_param.gpuIdx = -1;
+    }
+#else
+    DEBUG_LOG("gpu option is not enabled...");
+    m_param.gpuIdx = -1;
+#endif
+
+    if (m_param.gpuIdx >= 0) {
+        torch::NoGradGuard no_grad;
+        m_device = torch::Device(torch::kCUDA, m_param.gpuIdx);
+    }
+    DEBUG_LOG("use device: %s", m_device.str().c_str());
+    m_module.eval();
+
+    if (!m_device.is_cpu()) {
+        m_module.to(m_device);
+    }
+}
+
+NamedTensors TorchScriptEngine::forward(const NamedTensors& inputs)
+{
+    torch::NoGradGuard no_grad;
+
+    torch::Dict<std::string, torch::Tensor> data;
+    for (const auto& input : inputs) {
+        auto x = ::toTorchTensor(input.second);
+        if (!m_device.is_cpu()) {
+            x = x.to(m_device);
+        }
+        data.insert(input.first, std::move(x));
+    }
+
+    NamedTensors outputs;
+    for (const auto& output : m_module.forward({std::move(data)}).toGenericDict()) {
+        const auto& value = output.value();
+        outputs.emplace(output.key().toStringRef(),
+                        ::fromTorchTensor(value.isTensor() ? value.toTensor() : value.toTensorVector().at(0)));
+    }
+
+    return outputs;
+}
+}  // namespace _cv
+
+namespace
+{
+torch::Tensor toTorchTensor(const _cv::Tensor& tensor)
+{
+    if (tensor.data.depth() == CV_32F) {
+        return torch::from_blob(tensor.data.data, tensor.shape, torch::kFloat);
+    }
+
+    // integer inputs of the scripted models are int64, the index type of torch
+    return torch::from_blob(tensor.data.data, tensor.shape, torch::kInt32).to(torch::kInt64);
+}
+
+_cv::Tensor fromTorchTensor(torch::Tensor tensor)
+{
+    tensor = tensor.detach().cpu();
+    tensor = tensor.is_floating_point() ? tensor.to(torch::kFloat) : tensor.to(torch::kInt32);
+    tensor = tensor.contiguous();
+
+    _cv::Tensor result;
+    result.shape = tensor.sizes().vec();
+    result.data = cv::Mat(1, tensor.numel(), tensor.is_floating_point() ? CV_32F : CV_32S);
+    if (tensor.numel() > 0) {
+        std::memcpy(result.data.data, tensor.data_ptr(), tensor.numel() * tensor.element_size());
+    }
+
+    return result;
+}
+}  // namespace
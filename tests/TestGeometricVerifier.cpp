@@ -0,0 +1,232 @@
+/**
+ * @file    TestGeometricVerifier.cpp
+ *
+ * @author  btran
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <torch_cpp/torch_cpp.hpp>
+
+namespace
+{
+const cv::Matx33d K(500, 0, 320, 0, 500, 240, 0, 0, 1);
+
+// the last numOutliers matches are outliers with random train keypoints
+void makeMatches(const std::vector<cv::Point2f>& pts1, const std::vector<cv::Point2f>& pts2, int numOutliers,
+                 std::vector<cv::KeyPoint>& kpts1, std::vector<cv::KeyPoint>& kpts2, std::vector<cv::DMatch>& matches);
+
+void makeHomographyScene(const cv::Matx33d& H, int numInliers, int numOutliers, std::vector<cv::KeyPoint>& kpts1,
+                         std::vector<cv::KeyPoint>& kpts2, std::vector<cv::DMatch>& matches);
+
+void makeTwoViewScene(int numInliers, int numOutliers, std::vector<cv::KeyPoint>& kpts1,
+                      std::vector<cv::KeyPoint>& kpts2, std::vector<cv::DMatch>& matches);
+
+void checkMatchMask(const std::vector<char>& matchMask, int numInliers, int numOutliers);
+}  // namespace
+
+TEST(TestGeometricVerifier, TestInitializationFailure)
+{
+    _cv::GeometricVerifier::Param param;
+    param.inlierThresh = 0;
+    EXPECT_ANY_THROW({ cv::Ptr<_cv::GeometricVerifier> verifier = _cv::GeometricVerifier::create(param); });
+
+    param = _cv::GeometricVerifier::Param();
+    param.confidence = 1;
+    EXPECT_ANY_THROW({ cv::Ptr<_cv::GeometricVerifier> verifier = _cv::GeometricVerifier::create(param); });
+
+    param = _cv::GeometricVerifier::Param();
+    param.model = _cv::GeometricVerifier::Model::ESSENTIAL;
+    param.cameraMatrix = cv::Matx33d::zeros();
+    EXPECT_ANY_THROW({ cv::Ptr<_cv::GeometricVerifier> verifier = _cv::GeometricVerifier::create(param); });
+}
+
+TEST(TestGeometricVerifier, TestTooFewMatches)
+{
+    cv::Ptr<_cv::GeometricVerifier> verifier = _cv::GeometricVerifier::create(_cv::GeometricVerifier::Param());
+
+    std::vector<cv::KeyPoint> kpts1, kpts2;
+    std::vector<cv::DMatch> matches;
+    ::makeHomographyScene(cv::Matx33d::eye(), 3, 0, kpts1, kpts2, matches);
+
+    std::vector<char> matchMask;
+    cv::Mat H = verifier->verify(kpts1, kpts2, matches, matchMask);
+    EXPECT_TRUE(H.empty());
+    ASSERT_EQ(matchMask.size(), matches.size());
+    for (char isInlier : matchMask) {
+        EXPECT_EQ(isInlier, 0);
+    }
+}
+
+TEST(TestGeometricVerifier, TestHomography)
+{
+    const cv::Matx33d gtH(0.9, 0.05, 30, -0.04, 1.1, -10, 1e-4, -5e-5, 1);
+    const int numInliers = 200;
+    const int numOutliers = 100;
+
+    std::vector<cv::KeyPoint> kpts1, kpts2;
+    std::vector<cv::DMatch> matches;
+    ::makeHomographyScene(gtH, numInliers, numOutliers, kpts1, kpts2, matches);
+
+    _cv::GeometricVerifier::Param param;
+    param.model = _cv::GeometricVerifier::Model::HOMOGRAPHY;
+    cv::Ptr<_cv::GeometricVerifier> verifier = _cv::GeometricVerifier::create(param);
+
+    std::vector<char> matchMask;
+    cv::Mat H = verifier->verify(kpts1, kpts2, matches, matchMask);
+    ASSERT_FALSE(H.empty());
+    EXPECT_EQ(H.type(), CV_64F);
+    H /= H.at<double>(2, 2);
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 2; ++j) {
+            EXPECT_NEAR(H.at<double>(i, j), gtH(i, j), 1e-2 * std::max(1., std::abs(gtH(i, j))));
+        }
+    }
+    EXPECT_NEAR(H.at<double>(0, 2), gtH(0, 2), 1);
+    EXPECT_NEAR(H.at<double>(1, 2), gtH(1, 2), 1);
+
+    ::checkMatchMask(matchMask, numInliers, numOutliers);
+}
+
+TEST(TestGeometricVerifier, TestFundamental)
+{
+    const int numInliers = 200;
+    const int numOutliers = 100;
+
+    std::vector<cv::KeyPoint> kpts1, kpts2;
+    std::vector<cv::DMatch> matches;
+    ::makeTwoViewScene(numInliers, numOutliers, kpts1, kpts2, matches);
+
+    _cv::GeometricVerifier::Param param;
+    param.model = _cv::GeometricVerifier::Model::FUNDAMENTAL;
+    param.inlierThresh = 1.5;
+    cv::Ptr<_cv::GeometricVerifier> verifier = _cv::GeometricVerifier::create(param);
+
+    std::vector<char> matchMask;
+    cv::Mat F = verifier->verify(kpts1, kpts2, matches, matchMask);
+    ASSERT_FALSE(F.empty());
+    EXPECT_EQ(F.size(), cv::Size(3, 3));
+    ::checkMatchMask(matchMask, numInliers, numOutliers);
+}
+
+TEST(TestGeometricVerifier, TestEssential)
+{
+    const int numInliers = 200;
+    const int numOutliers = 100;
+
+    std::vector<cv::KeyPoint> kpts1, kpts2;
+    std::vector<cv::DMatch> matches;
+    ::makeTwoViewScene(numInliers, numOutliers, kpts1, kpts2, matches);
+
+    _cv::GeometricVerifier::Param param;
+    param.model = _cv::GeometricVerifier::Model::ESSENTIAL;
+    param.inlierThresh = 1.5;
+    param.cameraMatrix = K;
+    cv::Ptr<_cv::GeometricVerifier> verifier = _cv::GeometricVerifier::create(param);
+
+    std::vector<char> matchMask;
+    cv::Mat E = verifier->verify(kpts1, kpts2, matches, matchMask);
+    ASSERT_FALSE(E.empty());
+    EXPECT_EQ(E.size(), cv::Size(3, 3));
+    ::checkMatchMask(matchMask, numInliers, numOutliers);
+}
+
+TEST(TestGeometricVerifier, TestMultiplePairs)
+{
+    const cv::Matx33d gtH(1.05, 0.02, -15, 0.01, 0.95, 20, 0, 0, 1);
+    const int numInliers = 150;
+    const int numOutliers = 50;
+
+    std::vector<std::vector<cv::KeyPoint>> keyPointsList(4);
+    std::vector<std::vector<cv::DMatch>> matchesList(2);
+    ::makeHomographyScene(gtH, numInliers, numOutliers, keyPointsList[0], keyPointsList[1], matchesList[0]);
+    ::makeHomographyScene(gtH.inv(), numInliers, numOutliers, keyPointsList[2], keyPointsList[3], matchesList[1]);
+    const std::vector<std::pair<int, int>> imagePairs = {{0, 1}, {2, 3}};
+
+    cv::Ptr<_cv::GeometricVerifier> verifier = _cv::GeometricVerifier::create(_cv::GeometricVerifier::Param());
+    std::vector<cv::Mat> models;
+    std::vector<std::vector<char>> matchMasks;
+    verifier->verify(keyPointsList, imagePairs, matchesList, models, matchMasks);
+    ASSERT_EQ(models.size(), imagePairs.size());
+    ASSERT_EQ(matchMasks.size(), imagePairs.size());
+
+    for (std::size_t i = 0; i < imagePairs.size(); ++i) {
+        std::vector<char> matchMask;
+        cv::Mat H = verifier->verify(keyPointsList[imagePairs[i].first], keyPointsList[imagePairs[i].second],
+                                     matchesList[i], matchMask);
+        ASSERT_FALSE(models[i].empty());
+        EXPECT_LT(cv::norm(H, models[i], cv::NORM_INF), 1e-9);
+        EXPECT_EQ(matchMask, matchMasks[i]);
+    }
+
+    const std::vector<std::pair<int, int>> invalidImagePairs = {{0, 4}};
+    EXPECT_ANY_THROW(verifier->verify(keyPointsList, invalidImagePairs, matchesList, models, matchMasks));
+}
+
+namespace
+{
+void makeMatches(const std::vector<cv::Point2f>& pts1, const std::vector<cv::Point2f>& pts2, int numOutliers,
+                 std::vector<cv::KeyPoint>& kpts1, std::vector<cv::KeyPoint>& kpts2, std::vector<cv::DMatch>& matches)
+{
+    cv::RNG rng(2022);
+    const int numInliers = pts1.size() - numOutliers;
+
+    kpts1.clear();
+    kpts2.clear();
+    matches.clear();
+    for (std::size_t i = 0; i < pts1.size(); ++i) {
+        bool isInlier = static_cast<int>(i) < numInliers;
+        cv::Point2f pt2 =
+            isInlier ? pts2[i] + cv::Point2f(rng.gaussian(0.3), rng.gaussian(0.3))
+                     : cv::Point2f(rng.uniform(0.f, 640.f), rng.uniform(0.f, 480.f));
+        kpts1.emplace_back(pts1[i], 1);
+        kpts2.emplace_back(pt2, 1);
+
+        // confidences are informative but not perfect
+        float distance = isInlier ? rng.uniform(0.f, 0.7f) : rng.uniform(0.3f, 1.f);
+        matches.emplace_back(i, i, distance);
+    }
+}
+
+void makeHomographyScene(const cv::Matx33d& H, int numInliers, int numOutliers, std::vector<cv::KeyPoint>& kpts1,
+                         std::vector<cv::KeyPoint>& kpts2, std::vector<cv::DMatch>& matches)
+{
+    cv::RNG rng(2023);
+    std::vector<cv::Point2f> pts1, pts2;
+    for (int i = 0; i < numInliers + numOutliers; ++i) {
+        pts1.emplace_back(rng.uniform(0.f, 640.f), rng.uniform(0.f, 480.f));
+    }
+    cv::perspectiveTransform(pts1, pts2, H);
+    ::makeMatches(pts1, pts2, numOutliers, kpts1, kpts2, matches);
+}
+
+void makeTwoViewScene(int numInliers, int numOutliers, std::vector<cv::KeyPoint>& kpts1,
+                      std::vector<cv::KeyPoint>& kpts2, std::vector<cv::DMatch>& matches)
+{
+    cv::Matx33d R;
+    cv::Rodrigues(cv::Vec3d(0.05, -0.1, 0.02), R);
+    const cv::Vec3d t(1, 0.1, 0.05);
+
+    cv::RNG rng(2024);
+    std::vector<cv::Point2f> pts1, pts2;
+    for (int i = 0; i < numInliers + numOutliers; ++i) {
+        cv::Vec3d X(rng.uniform(-5., 5.), rng.uniform(-4., 4.), rng.uniform(10., 20.));
+        cv::Vec3d x1 = K * X;
+        cv::Vec3d x2 = K * (R * X + t);
+        pts1.emplace_back(x1[0] / x1[2], x1[1] / x1[2]);
+        pts2.emplace_back(x2[0] / x2[2], x2[1] / x2[2]);
+    }
+    ::makeMatches(pts1, pts2, numOutliers, kpts1, kpts2, matches);
+}
+
+void checkMatchMask(const std::vector<char>& matchMask, int numInliers, int numOutliers)
+{
+    ASSERT_EQ(static_cast<int>(matchMask.size()), numInliers + numOutliers);
+
+    int numTruePositives = std::count(matchMask.begin(), matchMask.begin() + numInliers, 1);
+    int numFalsePositives = std::count(matchMask.begin() + numInliers, matchMask.end(), 1);
+    EXPECT_GE(numTruePositives, numInliers * 0.95);
+    EXPECT_LE(numFalsePositives, numOutliers * 0.1);
+}
+}  // namespace
@@ -0,0 +1,198 @@
+/**
+ * @file    TestImageRetrieval.cpp
+ *
+ * @author  btran
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <torch_cpp/torch_cpp.hpp>
+
+namespace
+{
+constexpr int DESCRIPTOR_SIZE = 256;
+constexpr int NUM_IMAGES = 20;
+
+class TestImageRetrieval : public ::testing::Test
+{
+ protected:
+    void SetUp() override;
+
+    // noisy superpoint-like descriptors drawn around the scene words seen by the image
+    cv::Mat sampleDescriptors(int imageIdx, int numDescriptors, cv::RNG& rng) const;
+
+ protected:
+    cv::Mat m_sceneWords;
+    std::vector<std::vector<int>> m_wordsPerImage;
+};
+}  // namespace
+
+TEST(TestImageRetrievalInitialization, TestInitializationFailure)
+{
+    _cv::ImageRetrieval::Param param;
+    param.numVisualWords = 0;
+    EXPECT_ANY_THROW({ cv::Ptr<_cv::ImageRetrieval> retrieval = _cv::ImageRetrieval::create(param); });
+
+    param = _cv::ImageRetrieval::Param();
+    param.maxTrainingDescriptors = 0;
+    EXPECT_ANY_THROW({ cv::Ptr<_cv::ImageRetrieval> retrieval = _cv::ImageRetrieval::create(param); });
+
+    param = _cv::ImageRetrieval::Param();
+    param.pathToVocabulary = "/path/to/nonexistent/vocabulary.yml";
+    EXPECT_ANY_THROW({ cv::Ptr<_cv::ImageRetrieval> retrieval = _cv::ImageRetrieval::create(param); });
+
+    cv::Ptr<_cv::ImageRetrieval> retrieval = _cv::ImageRetrieval::create(_cv::ImageRetrieval::Param());
+    EXPECT_ANY_THROW(retrieval->add(cv::Mat::zeros(10, DESCRIPTOR_SIZE, CV_32F)));
+}
+
+TEST_F(TestImageRetrieval, TestQuery)
+{
+    _cv::ImageRetrieval::Param param;
+    param.numVisualWords = 16;
+    param.globalDescriptorSize = 16;
+    param.numLists = 4;
+    param.numProbes = 4;
+    cv::Ptr<_cv::ImageRetrieval> retrieval = _cv::ImageRetrieval::create(param);
+
+    cv::RNG rng(2022);
+    std::vector<cv::Mat> descriptorsList;
+    for (int i = 0; i < NUM_IMAGES; ++i) {
+        descriptorsList.emplace_back(this->sampleDescriptors(i, 200, rng));
+    }
+    retrieval->train(descriptorsList);
+
+    for (int i = 0; i < NUM_IMAGES; ++i) {
+        EXPECT_EQ(retrieval->add(descriptorsList[i]), i);
+    }
+    EXPECT_EQ(retrieval->size(), NUM_IMAGES);
+
+    cv::Mat globalDescriptor;
+    retrieval->computeGlobalDescriptor(descriptorsList[0], globalDescriptor);
+    EXPECT_EQ(globalDescriptor.rows, 1);
+    EXPECT_EQ(globalDescriptor.cols, param.globalDescriptorSize);
+    EXPECT_NEAR(cv::norm(globalDescriptor), 1, 1e-4);
+
+    const int k = 3;
+    for (int i = 0; i < NUM_IMAGES; ++i) {
+        std::vector<cv::DMatch> candidates;
+        retrieval->query(this->sampleDescriptors(i, 200, rng), k, candidates);
+        ASSERT_EQ(candidates.size(), k);
+        EXPECT_EQ(candidates[0].trainIdx, i);
+        for (int j = 1; j < k; ++j) {
+            EXPECT_LE(candidates[j - 1].distance, candidates[j].distance);
+        }
+    }
+}
+
+TEST_F(TestImageRetrieval, TestCandidatePairs)
+{
+    _cv::ImageRetrieval::Param param;
+    param.numVisualWords = 16;
+    param.globalDescriptorSize = 16;
+    param.numLists = 4;
+    param.numProbes = 2;
+    cv::Ptr<_cv::ImageRetrieval> retrieval = _cv::ImageRetrieval::create(param);
+
+    cv::RNG rng(2023);
+    std::vector<cv::Mat> descriptorsList;
+    for (int i = 0; i < NUM_IMAGES; ++i) {
+        descriptorsList.emplace_back(this->sampleDescriptors(i, 200, rng));
+    }
+    retrieval->train(descriptorsList);
+    for (const auto& descriptors : descriptorsList) {
+        retrieval->add(descriptors);
+    }
+
+    const int k = 2;
+    std::vector<std::pair<int, int>> imagePairs;
+    retrieval->findCandidatePairs(k, imagePairs);
+    EXPECT_FALSE(imagePairs.empty());
+    EXPECT_LE(imagePairs.size(), NUM_IMAGES * k);
+    for (const auto& imagePair : imagePairs) {
+        EXPECT_LT(imagePair.first, imagePair.second);
+        EXPECT_GE(imagePair.first, 0);
+        EXPECT_LT(imagePair.second, NUM_IMAGES);
+    }
+}
+
+TEST_F(TestImageRetrieval, TestSaveAndLoad)
+{
+    _cv::ImageRetrieval::Param param;
+    param.numVisualWords = 16;
+    param.globalDescriptorSize = 8;
+    param.numLists = 4;
+    cv::Ptr<_cv::ImageRetrieval> retrieval = _cv::ImageRetrieval::create(param);
+
+    cv::RNG rng(2024);
+    std::vector<cv::Mat> descriptorsList;
+    for (int i = 0; i < NUM_IMAGES; ++i) {
+        descriptorsList.emplace_back(this->sampleDescriptors(i, 100, rng));
+    }
+    retrieval->train(descriptorsList);
+
+    param.pathToVocabulary = ::testing::TempDir() + "torch_cpp_vocabulary.yml";
+    retrieval->save(param.pathToVocabulary);
+    cv::Ptr<_cv::ImageRetrieval> loadedRetrieval = _cv::ImageRetrieval::create(param);
+
+    cv::Mat globalDescriptor, loadedGlobalDescriptor;
+    retrieval->computeGlobalDescriptor(descriptorsList[0], globalDescriptor);
+    loadedRetrieval->computeGlobalDescriptor(descriptorsList[0], loadedGlobalDescriptor);
+    EXPECT_LT(cv::norm(globalDescriptor, loadedGlobalDescriptor, cv::NORM_INF), 1e-5);
+}
+
+TEST_F(TestImageRetrieval, TestTooFewImagesForPca)
+{
+    _cv::ImageRetrieval::Param param;
+    param.numVisualWords = 16;
+    param.globalDescriptorSize = NUM_IMAGES + 1;
+    param.numLists = 4;
+    cv::Ptr<_cv::ImageRetrieval> retrieval = _cv::ImageRetrieval::create(param);
+
+    cv::RNG rng(2025);
+    std::vector<cv::Mat> descriptorsList;
+    for (int i = 0; i < NUM_IMAGES; ++i) {
+        descriptorsList.emplace_back(this->sampleDescriptors(i, 100, rng));
+    }
+    EXPECT_ANY_THROW(retrieval->train(descriptorsList));
+}
+
+namespace
+{
+void TestImageRetrieval::SetUp()
+{
+    const int numSceneWords = 60;
+    const int numWordsPerImage = 8;
+
+    cv::RNG rng(2021);
+    m_sceneWords.create(numSceneWords, DESCRIPTOR_SIZE, CV_32F);
+    rng.fill(m_sceneWords, cv::RNG::NORMAL, cv::Scalar(0), cv::Scalar(1));
+    for (int i = 0; i < numSceneWords; ++i) {
+        cv::Mat word = m_sceneWords.row(i);
+        word /= cv::norm(word);
+    }
+
+    m_wordsPerImage.resize(NUM_IMAGES);
+    for (auto& words : m_wordsPerImage) {
+        while (static_cast<int>(words.size()) < numWordsPerImage) {
+            int wordIdx = rng.uniform(0, numSceneWords);
+            if (std::find(words.begin(), words.end(), wordIdx) == words.end()) {
+                words.emplace_back(wordIdx);
+            }
+        }
+    }
+}
+
+cv::Mat TestImageRetrieval::sampleDescriptors(int imageIdx, int numDescriptors, cv::RNG& rng) const
+{
+    const auto& words = m_wordsPerImage[imageIdx];
+    cv::Mat descriptors(numDescriptors, DESCRIPTOR_SIZE, CV_32F);
+    rng.fill(descriptors, cv::RNG::NORMAL, cv::Scalar(0), cv::Scalar(0.02));
+    for (int i = 0; i < numDescriptors; ++i) {
+        cv::Mat descriptor = descriptors.row(i);
+        descriptor += m_sceneWords.row(words[rng.uniform(0, static_cast<int>(words.size()))]);
+        descriptor /= cv::norm(descriptor);
+    }
+    return descriptors;
+}
+}  // namespace
@@ -5,6 +5,8 @@
  *
  */
 
+#include <map>
+
 #include <gtest/gtest.h>
 
 #include <torch_cpp/torch_cpp.hpp>
@@ -17,9 +19,136 @@ TEST(TestSuperGlue, TestInitializationFailure)
     EXPECT_ANY_THROW({ cv::Ptr<_cv::SuperGlue> superGlue = _cv::SuperGlue::create(param); });
 }
 
+#if ENABLE_TORCH
 TEST(TestSuperGlue, TestInitializationSuccess)
 {
     _cv::SuperGlue::Param param;
     param.pathToWeights = std::string(DATA_PATH) + "/superglue_model.pt";
     EXPECT_NO_THROW({ cv::Ptr<_cv::SuperGlue> superGlue = _cv::SuperGlue::create(param); });
 }
+#endif
+
+#if ENABLE_ONNXRUNTIME
+TEST(TestSuperGlue, TestOnnxInitializationSuccess)
+{
+    _cv::SuperGlue::Param param;
+    param.backend = _cv::InferenceBackend::ONNXRUNTIME;
+    param.pathToWeights = std::string(DATA_PATH) + "/superglue_model.onnx";
+    EXPECT_NO_THROW({ cv::Ptr<_cv::SuperGlue> superGlue = _cv::SuperGlue::create(param); });
+}
+
+TEST(TestSuperGlue, TestOnnxMatching)
+{
+    _cv::SuperPoint::Param superPointParam;
+    superPointParam.backend = _cv::InferenceBackend::ONNXRUNTIME;
+    superPointParam.pathToWeights = std::string(DATA_PATH) + "/superpoint_model.onnx";
+    cv::Ptr<cv::Feature2D> superPoint = _cv::SuperPoint::create(superPointParam);
+
+    _cv::SuperGlue::Param param;
+    param.backend = _cv::InferenceBackend::ONNXRUNTIME;
+    param.pathToWeights = std::string(DATA_PATH) + "/superglue_model.onnx";
+    cv::Ptr<_cv::SuperGlue> superGlue = _cv::SuperGlue::create(param);
+
+    std::vector<cv::Mat> images;
+    std::vector<std::vector<cv::KeyPoint>> keyPointsList(2);
+    std::vector<cv::Mat> descriptorsList(2);
+    for (const std::string imageName : {"VisionCS_0a.png", "VisionCS_0b.png"}) {
+        images.emplace_back(cv::imread(std::string(DATA_PATH) + "/images/" + imageName, 0));
+    }
+    for (int i = 0; i < 2; ++i) {
+        superPoint->detectAndCompute(images[i], cv::Mat(), keyPointsList[i], descriptorsList[i]);
+    }
+
+    std::vector<cv::DMatch> matches;
+    superGlue->match(descriptorsList[0], keyPointsList[0], images[0].size(), descriptorsList[1], keyPointsList[1],
+                     images[1].size(), matches);
+    ASSERT_GT(matches.size(), 0);
+
+    std::vector<char> isMatched(keyPointsList[1].size(), 0);
+    for (const auto& match : matches) {
+        ASSERT_GE(match.queryIdx, 0);
+        ASSERT_LT(match.queryIdx, static_cast<int>(keyPointsList[0].size()));
+        ASSERT_GE(match.trainIdx, 0);
+        ASSERT_LT(match.trainIdx, static_cast<int>(keyPointsList[1].size()));
+        EXPECT_GE(match.distance, 0);
+        EXPECT_LE(match.distance, 1 - param.matchThreshold);
+
+        // mutual matches, so each train keypoint is matched at most once
+        EXPECT_EQ(isMatched[match.trainIdx], 0);
+        isMatched[match.trainIdx] = 1;
+    }
+}
+
+TEST(TestSuperGlue, TestOnnxMatchingWithoutKeyPoints)
+{
+    _cv::SuperGlue::Param param;
+    param.backend = _cv::InferenceBackend::ONNXRUNTIME;
+    param.pathToWeights = std::string(DATA_PATH) + "/superglue_model.onnx";
+    cv::Ptr<_cv::SuperGlue> superGlue = _cv::SuperGlue::create(param);
+
+    const cv::Size imageSize(640, 480);
+    cv::Mat descriptors(10, 256, CV_32F, cv::Scalar(1 / 16.));
+    std::vector<cv::KeyPoint> keyPoints;
+    for (int i = 0; i < descriptors.rows; ++i) {
+        keyPoints.emplace_back(cv::Point2f(10 * i, 10 * i), 1, -1, 0.5);
+    }
+    cv::Mat emptyDescriptors(0, 256, CV_32F);
+    std::vector<cv::KeyPoint> emptyKeyPoints;
+
+    std::vector<cv::DMatch> matches;
+    EXPECT_NO_THROW(
+        superGlue->match(descriptors, keyPoints, imageSize, emptyDescriptors, emptyKeyPoints, imageSize, matches));
+    EXPECT_TRUE(matches.empty());
+    EXPECT_NO_THROW(
+        superGlue->match(emptyDescriptors, emptyKeyPoints, imageSize, descriptors, keyPoints, imageSize, matches));
+    EXPECT_TRUE(matches.empty());
+}
+#endif
+
+#if ENABLE_TORCH && ENABLE_ONNXRUNTIME
+TEST(TestSuperGlue, TestBackendParity)
+{
+    _cv::SuperPoint::Param superPointParam;
+    superPointParam.pathToWeights = std::string(DATA_PATH) + "/superpoint_model.pt";
+    cv::Ptr<cv::Feature2D> superPoint = _cv::SuperPoint::create(superPointParam);
+
+    std::vector<cv::Mat> images;
+    std::vector<std::vector<cv::KeyPoint>> keyPointsList(2);
+    std::vector<cv::Mat> descriptorsList(2);
+    for (const std::string imageName : {"VisionCS_0a.png", "VisionCS_0b.png"}) {
+        images.emplace_back(cv::imread(std::string(DATA_PATH) + "/images/" + imageName, 0));
+    }
+    for (int i = 0; i < 2; ++i) {
+        superPoint->detectAndCompute(images[i], cv::Mat(), keyPointsList[i], descriptorsList[i]);
+    }
+
+    std::vector<std::vector<cv::DMatch>> matchesList(2);
+    for (const auto backend : {_cv::InferenceBackend::TORCHSCRIPT, _cv::InferenceBackend::ONNXRUNTIME}) {
+        _cv::SuperGlue::Param param;
+        param.backend = backend;
+        param.pathToWeights = std::string(DATA_PATH) + "/superglue_model" +
+                              (backend == _cv::InferenceBackend::TORCHSCRIPT ? ".pt" : ".onnx");
+        cv::Ptr<_cv::SuperGlue> superGlue = _cv::SuperGlue::create(param);
+        superGlue->match(descriptorsList[0], keyPointsList[0], images[0].size(), descriptorsList[1], keyPointsList[1],
+                         images[1].size(), matchesList[static_cast<int>(backend)]);
+    }
+    ASSERT_GT(matchesList[0].size(), 0);
+
+    std::map<int, const cv::DMatch*> torchMatches;
+    for (const auto& match : matchesList[0]) {
+        torchMatches.emplace(match.queryIdx, &match);
+    }
+
+    int numCommonMatches = 0;
+    for (const auto& match : matchesList[1]) {
+        auto it = torchMatches.find(match.queryIdx);
+        if (it == torchMatches.end() || it->second->trainIdx != match.trainIdx) {
+            continue;
+        }
+        ++numCommonMatches;
+        EXPECT_NEAR(it->second->distance, match.distance, 1e-3);
+    }
+    EXPECT_GE(numCommonMatches, matchesList[0].size() * 0.98);
+    EXPECT_GE(numCommonMatches, matchesList[1].size() * 0.98);
+}
+#endif
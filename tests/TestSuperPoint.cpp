@@ -5,6 +5,8 @@
  *
  */
 
+#include <map>
+
 #include <gtest/gtest.h>
 
 #include <torch_cpp/torch_cpp.hpp>
@@ -17,6 +19,14 @@ TEST(TestSuperPoint, TestInitializationFailure)
     EXPECT_ANY_THROW({ cv::Ptr<cv::Feature2D> superPoint = _cv::SuperPoint::create(param); });
 }
 
+TEST(TestSuperPoint, TestInferenceBackendFromWeights)
+{
+    EXPECT_EQ(_cv::inferenceBackendFromWeights("superpoint_model.onnx"), _cv::InferenceBackend::ONNXRUNTIME);
+    EXPECT_EQ(_cv::inferenceBackendFromWeights("superpoint_model.pt"), _cv::InferenceBackend::TORCHSCRIPT);
+    EXPECT_EQ(_cv::inferenceBackendFromWeights("onnx"), _cv::InferenceBackend::TORCHSCRIPT);
+}
+
+#if ENABLE_TORCH
 TEST(TestSuperPoint, TestInitializationSuccess)
 {
     _cv::SuperPoint::Param param;
@@ -50,3 +60,183 @@ TEST(TestSuperPoint, TestSuperPointDetection)
         EXPECT_NEAR(squaredSum, 1, 1e-4);
     }
 }
+
+TEST(TestSuperPoint, TestCropToMask)
+{
+    std::vector<cv::Ptr<cv::Feature2D>> superPoints;
+    for (bool cropToMask : {false, true}) {
+        _cv::SuperPoint::Param param;
+        param.pathToWeights = std::string(DATA_PATH) + "/superpoint_model.pt";
+        param.cropToMask = cropToMask;
+        superPoints.emplace_back(_cv::SuperPoint::create(param));
+    }
+
+    cv::Mat image = cv::imread(std::string(DATA_PATH) + "/images/30.jpg", 0);
+    cv::Mat mask = cv::Mat::zeros(image.size(), CV_8UC1);
+    mask(cv::Rect(0, 0, image.cols / 4, image.rows / 4)).setTo(255);
+    mask(cv::Rect(image.cols / 2, image.rows / 2, image.cols / 5, image.rows / 5)).setTo(255);
+
+    std::vector<std::vector<cv::KeyPoint>> keyPointsList(2);
+    std::vector<cv::Mat> descriptorsList(2);
+    for (int i = 0; i < 2; ++i) {
+        superPoints[i]->detectAndCompute(image, mask, keyPointsList[i], descriptorsList[i]);
+    }
+    ASSERT_GT(keyPointsList[0].size(), 0);
+    EXPECT_EQ(keyPointsList[1].size(), descriptorsList[1].rows);
+    EXPECT_NEAR(keyPointsList[0].size(), keyPointsList[1].size(), keyPointsList[0].size() * 0.1);
+    for (const auto& keyPoint : keyPointsList[1]) {
+        EXPECT_NE(mask.at<uchar>(cv::Point(keyPoint.pt)), 0);
+    }
+
+    std::map<std::pair<float, float>, int> fullFrameIndices;
+    for (std::size_t i = 0; i < keyPointsList[0].size(); ++i) {
+        fullFrameIndices.emplace(std::make_pair(keyPointsList[0][i].pt.x, keyPointsList[0][i].pt.y), i);
+    }
+    int numCommonKeyPoints = 0;
+    for (std::size_t i = 0; i < keyPointsList[1].size(); ++i) {
+        auto it = fullFrameIndices.find(std::make_pair(keyPointsList[1][i].pt.x, keyPointsList[1][i].pt.y));
+        if (it == fullFrameIndices.end()) {
+            continue;
+        }
+        ++numCommonKeyPoints;
+        EXPECT_GT(descriptorsList[0].row(it->second).dot(descriptorsList[1].row(i)), 0.9);
+    }
+    EXPECT_GE(numCommonKeyPoints, keyPointsList[0].size() * 0.8);
+
+    // the crops are cached on the mask's content: the same content in another buffer gives the same result
+    std::vector<cv::KeyPoint> keyPoints;
+    cv::Mat descriptors;
+    superPoints[1]->detectAndCompute(image, mask.clone(), keyPoints, descriptors);
+    ASSERT_EQ(keyPoints.size(), keyPointsList[1].size());
+    EXPECT_EQ(cv::norm(descriptors, descriptorsList[1], cv::NORM_INF), 0);
+
+    // a mask edited in place must not reuse the crops and resized mask of its previous content
+    mask.setTo(0);
+    mask(cv::Rect(image.cols * 3 / 4, 0, image.cols / 4, image.rows / 4)).setTo(255);
+    std::vector<cv::KeyPoint> fullFrameKeyPoints;
+    superPoints[0]->detectAndCompute(image, mask, fullFrameKeyPoints, descriptors);
+    superPoints[1]->detectAndCompute(image, mask, keyPoints, descriptors);
+    ASSERT_GT(fullFrameKeyPoints.size(), 0);
+    EXPECT_NEAR(keyPoints.size(), fullFrameKeyPoints.size(), fullFrameKeyPoints.size() * 0.1);
+    for (const auto& keyPoint : keyPoints) {
+        EXPECT_NE(mask.at<uchar>(cv::Point(keyPoint.pt)), 0);
+    }
+
+    // a mask without any region runs no crop
+    superPoints[1]->detectAndCompute(image, cv::Mat::zeros(image.size(), CV_8UC1), keyPoints, descriptors);
+    EXPECT_TRUE(keyPoints.empty());
+    EXPECT_EQ(descriptors.rows, 0);
+}
+#endif
+
+#if ENABLE_ONNXRUNTIME
+TEST(TestSuperPoint, TestOnnxInitializationSuccess)
+{
+    _cv::SuperPoint::Param param;
+    param.backend = _cv::InferenceBackend::ONNXRUNTIME;
+    param.pathToWeights = std::string(DATA_PATH) + "/superpoint_model.onnx";
+    EXPECT_NO_THROW({ cv::Ptr<cv::Feature2D> superPoint = _cv::SuperPoint::create(param); });
+}
+
+TEST(TestSuperPoint, TestOnnxSuperPointDetection)
+{
+    _cv::SuperPoint::Param param;
+    param.backend = _cv::InferenceBackend::ONNXRUNTIME;
+    param.pathToWeights = std::string(DATA_PATH) + "/superpoint_model.onnx";
+    cv::Ptr<cv::Feature2D> superPoint = _cv::SuperPoint::create(param);
+
+    cv::Mat image = cv::imread(std::string(DATA_PATH) + "/images/30.jpg", 0);
+    cv::Mat descriptors;
+    std::vector<cv::KeyPoint> keyPoints;
+    superPoint->detectAndCompute(image, cv::Mat(), keyPoints, descriptors);
+    ASSERT_GT(keyPoints.size(), 0);
+    EXPECT_EQ(keyPoints.size(), descriptors.rows);
+    EXPECT_EQ(descriptors.cols, superPoint->descriptorSize());
+
+    for (const auto& keyPoint : keyPoints) {
+        EXPECT_GE(keyPoint.pt.x, 0);
+        EXPECT_LT(keyPoint.pt.x, image.cols);
+        EXPECT_GE(keyPoint.pt.y, 0);
+        EXPECT_LT(keyPoint.pt.y, image.rows);
+    }
+
+    // test normalization
+    cv::Mat squaredSumMat;
+    cv::reduce(descriptors.mul(descriptors), squaredSumMat, 1, cv::REDUCE_SUM);
+    for (int i = 0; i < descriptors.rows; ++i) {
+        EXPECT_NEAR(squaredSumMat.ptr<float>()[i], 1, 1e-4);
+    }
+}
+#endif
+
+#if ENABLE_TORCH && ENABLE_ONNXRUNTIME
+namespace
+{
+// run both backends with the same param, and compare the keypoints they have in common
+void checkBackendParity(const _cv::SuperPoint::Param& param, const cv::Mat& image, const cv::Mat& mask)
+{
+    std::vector<cv::Ptr<cv::Feature2D>> superPoints;
+    for (const auto backend : {_cv::InferenceBackend::TORCHSCRIPT, _cv::InferenceBackend::ONNXRUNTIME}) {
+        _cv::SuperPoint::Param backendParam = param;
+        backendParam.backend = backend;
+        backendParam.pathToWeights = std::string(DATA_PATH) + "/superpoint_model" +
+                                     (backend == _cv::InferenceBackend::TORCHSCRIPT ? ".pt" : ".onnx");
+        superPoints.emplace_back(_cv::SuperPoint::create(backendParam));
+    }
+
+    std::vector<std::vector<cv::KeyPoint>> keyPointsList(2);
+    std::vector<cv::Mat> descriptorsList(2);
+    for (int i = 0; i < 2; ++i) {
+        superPoints[i]->detectAndCompute(image, mask, keyPointsList[i], descriptorsList[i]);
+    }
+    ASSERT_GT(keyPointsList[0].size(), 0);
+    EXPECT_NEAR(keyPointsList[0].size(), keyPointsList[1].size(), keyPointsList[0].size() * 0.01);
+
+    // keypoints whose scores are close to the threshold may differ, so compare the common ones
+    std::map<std::pair<float, float>, int> torchIndices;
+    for (std::size_t i = 0; i < keyPointsList[0].size(); ++i) {
+        torchIndices.emplace(std::make_pair(keyPointsList[0][i].pt.x, keyPointsList[0][i].pt.y), i);
+    }
+
+    int numCommonKeyPoints = 0;
+    for (std::size_t i = 0; i < keyPointsList[1].size(); ++i) {
+        auto it = torchIndices.find(std::make_pair(keyPointsList[1][i].pt.x, keyPointsList[1][i].pt.y));
+        if (it == torchIndices.end()) {
+            continue;
+        }
+        ++numCommonKeyPoints;
+        EXPECT_NEAR(keyPointsList[0][it->second].response, keyPointsList[1][i].response, 1e-4);
+        EXPECT_GT(descriptorsList[0].row(it->second).dot(descriptorsList[1].row(i)), 0.999);
+    }
+    EXPECT_GE(numCommonKeyPoints, keyPointsList[0].size() * 0.99);
+}
+}  // namespace
+
+TEST(TestSuperPoint, TestBackendParity)
+{
+    cv::Mat image = cv::imread(std::string(DATA_PATH) + "/images/30.jpg", 0);
+    ::checkBackendParity(_cv::SuperPoint::Param(), image, cv::Mat());
+}
+
+TEST(TestSuperPoint, TestBackendParityAtOtherInputSize)
+{
+    // the onnx model is exported at 480x640, other input sizes must not reuse shapes fixed at export
+    _cv::SuperPoint::Param param;
+    param.imageHeight = 360;
+    param.imageWidth = 512;
+    cv::Mat image = cv::imread(std::string(DATA_PATH) + "/images/30.jpg", 0);
+    ::checkBackendParity(param, image, cv::Mat());
+}
+
+TEST(TestSuperPoint, TestBackendParityCropToMask)
+{
+    // each crop is a different input size for the onnx model
+    _cv::SuperPoint::Param param;
+    param.cropToMask = true;
+    cv::Mat image = cv::imread(std::string(DATA_PATH) + "/images/30.jpg", 0);
+    cv::Mat mask = cv::Mat::zeros(image.size(), CV_8UC1);
+    mask(cv::Rect(0, 0, image.cols / 4, image.rows / 4)).setTo(255);
+    mask(cv::Rect(image.cols / 2, image.rows / 2, image.cols / 5, image.rows / 5)).setTo(255);
+    ::checkBackendParity(param, image, mask);
+}
+#endif